@@ -36,7 +36,8 @@ void setAnalyzerOptions(cxxopts::ParseResult &result, WFC::AnalyzerOptions &opti
             result["scale"].as<int>(),
             result["space"].as<int>(),
             result["rotate"].as<bool>(),
-            result["flip"].as<bool>()
+            result["flip"].as<bool>(),
+            Util::ThreadPool::resolveThreadCount(result["threads"].as<int>())
     };
 }
 
@@ -48,6 +49,23 @@ void setBacktrackerOptions(cxxopts::ParseResult &result, WFC::BacktrackerOptions
     };
 }
 
+void setSolverOptions(cxxopts::ParseResult &result, WFC::SolverOptions &options) {
+    options = {
+            Util::ThreadPool::resolveThreadCount(result["threads"].as<int>()),
+            static_cast<size_t>(std::max(1, result["collapse-batch"].as<int>())),
+            result["collapse-radius"].as<int>(),
+            result["components"].as<bool>(),
+            result.count("seed") ? result["seed"].as<uint64_t>() : Util::Random::randomSeed()
+    };
+}
+
+void setBatchOptions(cxxopts::ParseResult &result, WFC::BatchOptions &options) {
+    options = {
+            static_cast<size_t>(std::max(0, result["batch"].as<int>())),
+            static_cast<size_t>(std::max(1, result["batch-attempts"].as<int>()))
+    };
+}
+
 WFC::WFC createWFC(cxxopts::ParseResult &result, WFC::AnalyzerOptions &analyzerOptions, WFC::BacktrackerOptions &backtrackerOptions) {
     return WFC::WFC{result["input"].as<std::string>(),
                analyzerOptions,
@@ -71,6 +89,8 @@ int main(int argc, char *argv[]) {
     WFC::AnalyzerOptions analyzerOptions{};
     WFC::BacktrackerOptions backtrackerOptions{};
     WFC::WFCSavePaths savePaths{};
+    WFC::SolverOptions solverOptions{};
+    WFC::BatchOptions batchOptions{};
     cli.parseOptions(argc, argv);
     cxxopts::Options options = cli.getOptions();
     cxxopts::ParseResult result = cli.getResult();
@@ -83,12 +103,19 @@ int main(int argc, char *argv[]) {
     setLogFile(result);
     setAnalyzerOptions(result, analyzerOptions);
     setBacktrackerOptions(result, backtrackerOptions);
+    setSolverOptions(result, solverOptions);
+    setBatchOptions(result, batchOptions);
 
     auto wfc = createWFC(result, analyzerOptions, backtrackerOptions);
     setSavePaths(result, savePaths);
     wfc.setSavePaths(savePaths);
+    wfc.setSolverOptions(solverOptions);
 
     wfc.prepareWFC();
+    if (batchOptions.count > 0) {
+        wfc.startBatch(batchOptions);
+        return 0;
+    }
     wfc.startWFC();
     wfc.saveOutput();
 
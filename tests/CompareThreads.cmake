@@ -0,0 +1,34 @@
+# Runs the solver with one and with several threads and fails if the saved images differ.
+# Expects WFC, INPUT, WORK_DIR and ARGS (a ;-separated list of extra options) to be set with -D.
+
+set(images "")
+foreach (threads 1 4)
+    set(dir "${WORK_DIR}/threads${threads}")
+    file(REMOVE_RECURSE "${dir}")
+    file(MAKE_DIRECTORY "${dir}")
+    execute_process(COMMAND "${WFC}" -i "${INPUT}" --threads ${threads} ${ARGS}
+                    -o "${dir}/solutions/" -c "${dir}/failed/" -a "${dir}/iterations/" -t "${dir}/patterns/"
+                    -l "${dir}/wfc.log"
+                    RESULT_VARIABLE result OUTPUT_QUIET)
+    if (NOT result EQUAL 0)
+        message(FATAL_ERROR "Run with ${threads} threads exited with ${result}")
+    endif ()
+    file(GLOB_RECURSE outputs RELATIVE "${dir}" "${dir}/solutions/*.png" "${dir}/failed/*.png")
+    if (NOT outputs)
+        message(FATAL_ERROR "Run with ${threads} threads saved no image")
+    endif ()
+    list(SORT outputs)
+    set(hashes "")
+    foreach (output ${outputs})
+        file(SHA256 "${dir}/${output}" hash)
+        list(APPEND hashes "${output}=${hash}")
+    endforeach ()
+    string(JOIN "," hashes ${hashes})
+    list(APPEND images "${hashes}")
+endforeach ()
+
+list(GET images 0 single)
+list(GET images 1 multi)
+if (NOT single STREQUAL multi)
+    message(FATAL_ERROR "Images differ between 1 and 4 threads:\n  ${single}\n  ${multi}")
+endif ()
@@ -35,6 +35,20 @@ void Util::CLI::initOptions() {
              cxxopts::value<std::string>()->default_value("../outputs/failed/"))
             ("y,savePatterns", "Save patterns, iterations and failed output images",
              cxxopts::value<bool>()->default_value("false"))
+            ("threads", "Number of worker threads, 0 uses all hardware threads",
+             cxxopts::value<int>()->default_value("1"))
+            ("collapse-batch", "Number of distant cells collapsed per iteration",
+             cxxopts::value<int>()->default_value("1"))
+            ("collapse-radius", "Minimal distance between cells collapsed in the same iteration",
+             cxxopts::value<int>()->default_value("8"))
+            ("components", "Solve groups of cells that cannot affect each other separately",
+             cxxopts::value<bool>()->default_value("false"))
+            ("batch", "Number of outputs solved together in bit lanes, 0 solves a single output",
+             cxxopts::value<int>()->default_value("0"))
+            ("batch-attempts", "Restarts of a batch output after contradiction before it is given up",
+             cxxopts::value<int>()->default_value("10"))
+            ("seed", "Master seed of the run, random if not set",
+             cxxopts::value<uint64_t>())
             ("help", "CLI for running WFC algorithm");
 }
 
@@ -0,0 +1,30 @@
+//
+// Created on 18.10.2026.
+//
+
+#include "Hash.h"
+
+#include <cstring>
+
+uint64_t Util::Hash::bytes(const void *data, size_t size, uint64_t seed) {
+    constexpr uint64_t multiplier = 0x9E3779B97F4A7C15ULL;
+    const auto *input = static_cast<const unsigned char *>(data);
+    uint64_t hash = seed ^ (size * multiplier);
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, input + i, 8);
+        hash = (hash ^ mix(word)) * multiplier;
+    }
+    uint64_t tail = 0;
+    for (size_t shift = 0; i < size; i++, shift += 8) {
+        tail |= static_cast<uint64_t>(input[i]) << shift;
+    }
+    return mix(hash ^ tail);
+}
+
+uint64_t Util::Hash::mix(uint64_t value) {
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+    return value ^ (value >> 31);
+}
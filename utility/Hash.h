@@ -0,0 +1,22 @@
+//
+// Created on 18.10.2026.
+//
+
+#ifndef WFC_HASH_H
+#define WFC_HASH_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Util {
+    class Hash {
+    public:
+        //64 bit hash of raw bytes, reads 8 bytes at a time
+        static uint64_t bytes(const void *data, size_t size, uint64_t seed = 0);
+
+        //final avalanche step, spreads every input bit over the whole result
+        static uint64_t mix(uint64_t value);
+    };
+}
+
+#endif //WFC_HASH_H
@@ -0,0 +1,23 @@
+//
+// Created on 18.10.2026.
+//
+
+#include "Random.h"
+
+uint64_t Util::Random::splitSeed(uint64_t masterSeed, uint64_t stream) {
+    //splitmix64 of the stream counter, consecutive streams end up with unrelated seeds
+    uint64_t z = masterSeed + (stream + 1) * 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+std::mt19937 Util::Random::makeGenerator(uint64_t seed) {
+    std::seed_seq sequence{static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32)};
+    return std::mt19937(sequence);
+}
+
+uint64_t Util::Random::randomSeed() {
+    std::random_device device;
+    return (static_cast<uint64_t>(device()) << 32) | device();
+}
@@ -0,0 +1,26 @@
+//
+// Created on 18.10.2026.
+//
+
+#ifndef WFC_RANDOM_H
+#define WFC_RANDOM_H
+
+#include <cstdint>
+#include <random>
+
+namespace Util {
+
+    //independent streams of random numbers derived from one master seed
+    class Random {
+    public:
+        //seed of stream number `stream`, depends only on the inputs so every thread derives the same one
+        static uint64_t splitSeed(uint64_t masterSeed, uint64_t stream);
+
+        static std::mt19937 makeGenerator(uint64_t seed);
+
+        //seed for runs without an explicit one
+        static uint64_t randomSeed();
+    };
+}
+
+#endif //WFC_RANDOM_H
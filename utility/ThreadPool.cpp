@@ -0,0 +1,89 @@
+//
+// Created on 18.10.2026.
+//
+
+#include "ThreadPool.h"
+
+Util::ThreadPool::ThreadPool(size_t threadCount) {
+    //the calling thread is used as one of the workers
+    for (size_t worker = 1; worker < threadCount; worker++) {
+        workers.emplace_back(&ThreadPool::workerLoop, this, worker);
+    }
+}
+
+Util::ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeCondition.notify_all();
+    for (auto &worker: workers) {
+        worker.join();
+    }
+}
+
+void Util::ThreadPool::parallelFor(size_t count, const ParallelTask &parallelTask, size_t minChunk) {
+    if (count == 0) {
+        return;
+    }
+    if (workers.empty() || count <= minChunk) {
+        parallelTask(0, count, 0);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        task = &parallelTask;
+        taskCount = count;
+        //few chunks per thread so that faster threads can steal the rest
+        chunkSize = std::max(minChunk, count / (getThreadCount() * 4));
+        nextIndex.store(0, std::memory_order_relaxed);
+        pendingWorkers = workers.size();
+        generation++;
+    }
+    wakeCondition.notify_all();
+
+    runChunks(0);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    doneCondition.wait(lock, [this] { return pendingWorkers == 0; });
+    task = nullptr;
+}
+
+size_t Util::ThreadPool::getThreadCount() const {
+    return workers.size() + 1;
+}
+
+size_t Util::ThreadPool::resolveThreadCount(int requested) {
+    if (requested > 0) {
+        return static_cast<size_t>(requested);
+    }
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+void Util::ThreadPool::workerLoop(size_t worker) {
+    size_t seenGeneration = 0;
+    while (true) {
+        std::unique_lock<std::mutex> lock(mutex);
+        wakeCondition.wait(lock, [&] { return stopping || generation != seenGeneration; });
+        if (stopping) {
+            return;
+        }
+        seenGeneration = generation;
+        lock.unlock();
+
+        runChunks(worker);
+
+        lock.lock();
+        if (--pendingWorkers == 0) {
+            doneCondition.notify_one();
+        }
+    }
+}
+
+void Util::ThreadPool::runChunks(size_t worker) {
+    size_t begin;
+    while ((begin = nextIndex.fetch_add(chunkSize, std::memory_order_relaxed)) < taskCount) {
+        (*task)(begin, std::min(begin + chunkSize, taskCount), worker);
+    }
+}
@@ -0,0 +1,61 @@
+//
+// Created on 18.10.2026.
+//
+
+#ifndef WFC_THREADPOOL_H
+#define WFC_THREADPOOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Util {
+
+    //task gets the range [begin, end) it should process and the index of the worker running it
+    using ParallelTask = std::function<void(size_t begin, size_t end, size_t worker)>;
+
+    //fixed pool of worker threads that splits loops into chunks, the calling thread works as worker 0
+    class ThreadPool {
+    public:
+        explicit ThreadPool(size_t threadCount);
+
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool &) = delete;
+
+        ThreadPool &operator=(const ThreadPool &) = delete;
+
+        //runs task over [0, count) and blocks until every chunk is done, must not be called from inside a task
+        void parallelFor(size_t count, const ParallelTask &task, size_t minChunk = 1);
+
+        [[nodiscard]] size_t getThreadCount() const;
+
+        //0 or less means use all hardware threads
+        static size_t resolveThreadCount(int requested);
+
+    private:
+        void workerLoop(size_t worker);
+
+        void runChunks(size_t worker);
+
+    private:
+        std::vector<std::thread> workers;
+        std::mutex mutex;
+        std::condition_variable wakeCondition;
+        std::condition_variable doneCondition;
+        const ParallelTask *task = nullptr;
+        size_t taskCount = 0;
+        size_t chunkSize = 1;
+        std::atomic<size_t> nextIndex{0};
+        size_t pendingWorkers = 0;
+        size_t generation = 0;
+        bool stopping = false;
+    };
+}
+
+#endif //WFC_THREADPOOL_H
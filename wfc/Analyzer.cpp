@@ -4,6 +4,8 @@
 
 #include "Analyzer.h"
 
+#include <cstring>
+
 
 WFC::Analyzer::Analyzer(AnalyzerOptions &options, std::string_view pathToInputImage) :
 options(options)
@@ -26,6 +28,8 @@ const cimg::CImg<unsigned char>& WFC::Analyzer::getInputImage() const {
 }
 
 void WFC::Analyzer::analyze() {
+    threadPool = std::make_unique<Util::ThreadPool>(std::max<size_t>(1, options.threads));
+    buildIndexImage();
     generatePatterns();
     generateOffsets();
     generateRules();
@@ -33,32 +37,155 @@ void WFC::Analyzer::analyze() {
     calculateProbabilities();
 }
 
+void WFC::Analyzer::buildIndexImage() {
+    Util::Timer timer("buildIndexImage");
+    palette = Palette(inputImage.spectrum());
+    size_t width = inputImage.width();
+    std::vector<size_t> indices(width * inputImage.height());
+    std::vector<uint8_t> color(inputImage.spectrum());
+    for (int y = 0; y < inputImage.height(); y++) {
+        for (int x = 0; x < inputImage.width(); x++) {
+            for (int c = 0; c < inputImage.spectrum(); c++) {
+                color[c] = inputImage(x, y, 0, c);
+            }
+            indices[y * width + x] = palette.indexOf(color.data());
+        }
+    }
+
+    //index width is only known once every colour was seen
+    indexBytes = palette.getIndexBytes();
+    indexImage.resize(indices.size() * indexBytes);
+    for (size_t i = 0; i < indices.size(); i++) {
+        Palette::writeIndex(indexImage.data(), i, indexBytes, indices[i]);
+    }
+    Util::Logger::log(Util::LogLevel::Info, "Input image has " + std::to_string(palette.size()) + " colors");
+}
+
 void WFC::Analyzer::generatePatterns(){
     Util::Timer timer("generatePatterns");
+    size_t rows = inputImage.height() - options.patternSize + 1;
+    //bands do not depend on which worker scans them, so the merge below always sees the same tables
+    size_t bandCount = std::min(rows, threadPool->getThreadCount() * 4);
+    symmetry = Symmetry(options.patternSize);
+    std::vector<uint8_t> transforms = Symmetry::group(options.rotate, options.flip);
+    std::vector<PatternBand> bands(bandCount);
+    threadPool->parallelFor(bandCount, [&](size_t begin, size_t end, size_t) {
+        for (size_t band = begin; band < end; band++) {
+            extractBand(rows * band / bandCount, rows * (band + 1) / bandCount, transforms, bands[band]);
+        }
+    });
+
+    //merging in band order assigns the same ids as a single scan over the whole image
+    patternTable = PatternTable(options.patternSize * options.patternSize * indexBytes);
+    patternFrequencies.clear();
     size_t totalPatterns = 0;
-    for (size_t x = 0; x <= inputImage.width() - options.patternSize; x++) {
-        for (size_t y = 0; y <= inputImage.height() - options.patternSize; y++) {
-            cimg::CImg<unsigned char> pattern = inputImage.get_crop(x, y, x + options.patternSize - 1,
-                                                                    y + options.patternSize - 1);
-            totalPatterns++;
-            addPattern(pattern);
-
-            if (options.flip) {
-                addPattern(pattern.get_mirror('x'));
-                addPattern(pattern.get_mirror('y'));
-                totalPatterns += 2;
+    for (const auto &band: bands) {
+        for (size_t id = 0; id < band.table.size(); id++) {
+            auto [patternId, inserted] = patternTable.insert(band.table.key(id), band.table.hashOf(id));
+            if (inserted) {
+                patternFrequencies.push_back(0);
+            }
+            patternFrequencies[patternId] += band.frequencies[id];
+        }
+        totalPatterns += band.windows;
+    }
+    Util::Logger::log(Util::LogLevel::Info, "Total possible patterns:  " + std::to_string(totalPatterns));
+    Util::Logger::log(Util::LogLevel::Info, "Generated " + std::to_string(getPatternCount()) + " patterns");
+    findSymmetryClasses(transforms);
+}
+
+void WFC::Analyzer::findSymmetryClasses(const std::vector<uint8_t> &transforms) {
+    size_t patternBytes = patternTable.getKeySize();
+    std::vector<uint8_t> variant(patternBytes);
+    std::vector<uint8_t> smallest(patternBytes);
+    canonicalPatterns.assign(getPatternCount(), 0);
+    patternTransforms.assign(getPatternCount(), Identity);
+    size_t classes = 0;
+    for (size_t pattern = 0; pattern < getPatternCount(); pattern++) {
+        //the variant with the smallest bytes represents the whole class
+        uint8_t smallestTransform = Identity;
+        std::memcpy(smallest.data(), getPattern(pattern), patternBytes);
+        for (uint8_t transform: transforms) {
+            symmetry.apply(transform, getPattern(pattern), variant.data(), indexBytes);
+            if (std::memcmp(variant.data(), smallest.data(), patternBytes) < 0) {
+                smallest.swap(variant);
+                smallestTransform = transform;
             }
+        }
+        //every window was added with all transforms of the group, so the representative is always in the table
+        canonicalPatterns[pattern] = patternTable.find(
+                RollingHash::hashPattern(smallest.data(), options.patternSize, indexBytes), [&](size_t id) {
+                    return std::memcmp(getPattern(id), smallest.data(), patternBytes) == 0;
+                });
+        patternTransforms[pattern] = Symmetry::inverse(smallestTransform);
+        if (canonicalPatterns[pattern] == pattern) {
+            classes++;
+        }
+    }
+    Util::Logger::log(Util::LogLevel::Info, "Patterns form " + std::to_string(classes) + " symmetry classes");
+}
+
+void WFC::Analyzer::extractBand(size_t firstRow, size_t endRow, const std::vector<uint8_t> &transforms,
+                                PatternBand &band) const {
+    size_t n = options.patternSize;
+    size_t windowSize = n * n;
+    band.table = PatternTable(windowSize * indexBytes);
+    std::vector<uint8_t> pattern(windowSize * indexBytes);
+
+    //where every element of a transformed window is in the index image, relative to the window corner
+    std::vector<size_t> sourceOffsets(transforms.size() * windowSize);
+    for (size_t variant = 0; variant < transforms.size(); variant++) {
+        const uint16_t *permutation = symmetry.permutation(transforms[variant]);
+        for (size_t element = 0; element < windowSize; element++) {
+            size_t sourceX = permutation[element] % n;
+            size_t sourceY = permutation[element] / n;
+            sourceOffsets[variant * windowSize + element] = (sourceY * inputImage.width() + sourceX) * indexBytes;
+        }
+    }
 
-            if (options.rotate) {
-                for (int angle = 90; angle <= 270; angle += 90) {
-                    addPattern(pattern.get_rotate(static_cast<float>(angle)));
-                    totalPatterns += 3;
+    RollingHash hasher(indexImage.data(), inputImage.width(), inputImage.height(), indexBytes, n, transforms);
+    for (size_t y = firstRow; y < endRow; y++) {
+        hasher.hashRow(y);
+        for (size_t x = 0; x <= inputImage.width() - n; x++) {
+            const uint8_t *window = indexImage.data() + (y * inputImage.width() + x) * indexBytes;
+            for (size_t variant = 0; variant < transforms.size(); variant++) {
+                const size_t *elementOffsets = sourceOffsets.data() + variant * windowSize;
+                uint64_t hash = hasher.get(variant, x);
+                size_t id = band.table.find(hash, [&](size_t id) {
+                    return windowMatches(band.table.key(id), window, elementOffsets);
+                });
+                //only a window that is not in the table yet is copied out of the image
+                if (id == PatternTable::npos) {
+                    for (size_t element = 0; element < windowSize; element++) {
+                        std::memcpy(pattern.data() + element * indexBytes, window + elementOffsets[element],
+                                    indexBytes);
+                    }
+                    id = band.table.insert(pattern.data(), hash).first;
+                    band.frequencies.push_back(0);
                 }
+                band.frequencies[id]++;
+                band.windows++;
             }
         }
     }
-    Util::Logger::log(Util::LogLevel::Info, "Total possible patterns:  " + std::to_string(totalPatterns));
-    Util::Logger::log(Util::LogLevel::Info, "Generated " + std::to_string(patterns.size()) + " patterns");
+}
+
+bool WFC::Analyzer::windowMatches(const uint8_t *pattern, const uint8_t *window, const size_t *elementOffsets) const {
+    size_t windowSize = options.patternSize * options.patternSize;
+    if (indexBytes == 1) {
+        for (size_t element = 0; element < windowSize; element++) {
+            if (pattern[element] != window[elementOffsets[element]]) {
+                return false;
+            }
+        }
+        return true;
+    }
+    for (size_t element = 0; element < windowSize; element++) {
+        if (std::memcmp(pattern + element * indexBytes, window + elementOffsets[element], indexBytes) != 0) {
+            return false;
+        }
+    }
+    return true;
 }
 
 void WFC::Analyzer::generateOffsets() {
@@ -76,16 +203,16 @@ void WFC::Analyzer::generateOffsets() {
 
 void WFC::Analyzer::generateRules() {
     Util::Timer timer("generateRules");
-    rules.resize(patterns.size());
+    size_t patternCount = getPatternCount();
 
     //iterate over all patterns
-    rules.resize(patterns.size());
-    for (size_t i = 0; i < patterns.size(); i++) {
+    rules.resize(patternCount);
+    for (size_t i = 0; i < patternCount; i++) {
         //iterate all offsets
         for (const auto &offset: offsets) {
             //iterate all patterns again to match against them
-            for (size_t j = i; j < patterns.size(); j++) {
-                if (checkForMatch(patterns[i], patterns[j], offset)) {
+            for (size_t j = i; j < patternCount; j++) {
+                if (checkForMatch(getPattern(i), getPattern(j), offset)) {
                     rules[i][offset].insert(j);
                     rules[j][{-offset.x, -offset.y}].insert(i);
                 }
@@ -97,23 +224,28 @@ void WFC::Analyzer::generateRules() {
     }
 }
 
-bool WFC::Analyzer::checkForMatch(const cimg::CImg<unsigned char> &p1, const cimg::CImg<unsigned char> &p2,
-                        const Util::Point &offset) const {
-    cimg::CImg<unsigned char> p1Offset = maskWithOffset(p1, offset);
-    cimg::CImg<unsigned char> p2Offset = maskWithOffset(p2, Util::Point(-offset.x, -offset.y));
+bool WFC::Analyzer::checkForMatch(const uint8_t *p1, const uint8_t *p2, const Util::Point &offset) const {
+    std::vector<uint8_t> p1Offset = maskWithOffset(p1, offset);
+    std::vector<uint8_t> p2Offset = maskWithOffset(p2, Util::Point(-offset.x, -offset.y));
     return p1Offset == p2Offset;
 }
 
-cimg::CImg<unsigned char> WFC::Analyzer::maskWithOffset(const cimg::CImg<unsigned char> &pattern, const Util::Point &offset) const {
+std::vector<uint8_t> WFC::Analyzer::maskWithOffset(const uint8_t *pattern, const Util::Point &offset) const {
+    int size = static_cast<int>(options.patternSize);
     //check bounds
-    if (abs(offset.x) > pattern.width() || abs(offset.y) > pattern.height()) {
+    if (abs(offset.x) > size || abs(offset.y) > size) {
         return {};
     }
     Util::Point p1 = {std::max(0, offset.x), std::max(0, offset.y)};
-    Util::Point p2 = {std::min(pattern.width() - 1, pattern.width() - 1 + offset.x),
-                std::min(pattern.height() - 1, pattern.height() - 1 + offset.y)};;
-
-    auto crop = pattern.get_crop(p1.x, p1.y, p2.x, p2.y);
+    Util::Point p2 = {std::min(size - 1, size - 1 + offset.x),
+                      std::min(size - 1, size - 1 + offset.y)};
+
+    std::vector<uint8_t> crop;
+    crop.reserve((p2.x - p1.x + 1) * (p2.y - p1.y + 1) * indexBytes);
+    for (int y = p1.y; y <= p2.y; y++) {
+        const uint8_t *row = pattern + (y * size + p1.x) * indexBytes;
+        crop.insert(crop.end(), row, row + (p2.x - p1.x + 1) * indexBytes);
+    }
     return crop;
 }
 
@@ -132,7 +264,7 @@ void WFC::Analyzer::logRules() {
                                      std::to_string(totalRulesPerPattern[i]));
     }
 
-    for (size_t patternIndex = 0; patternIndex < patterns.size(); ++patternIndex) {
+    for (size_t patternIndex = 0; patternIndex < getPatternCount(); ++patternIndex) {
         Util::Logger::log(Util::LogLevel::Debug, "Pattern number " + std::to_string(patternIndex) + ":");
         for (const auto &offset: offsets) {
             std::string possiblePatternsStr;
@@ -151,43 +283,16 @@ void WFC::Analyzer::logRules() {
     }
 }
 
-void WFC::Analyzer::addPattern(const cimg::CImg<unsigned char> &pattern) {
-    std::string patternStr = patternToStr(pattern);
-    if (patternFrequency.find(patternStr) == patternFrequency.end()) {
-        patternFrequency[patternStr] = 1;
-        patterns.push_back(pattern);
-    } else {
-        patternFrequency[patternStr]++;
-    }
-}
-
-std::string WFC::Analyzer::patternToStr(const cimg::CImg<unsigned char> &pattern) const {
-    std::string patternKey;
-    patternKey.reserve(pattern.width() * pattern.height() * pattern.spectrum() * 4);
-    for (int x = 0; x < pattern.width(); ++x) {
-        for (int y = 0; y < pattern.height(); ++y) {
-            for (int c = 0; c < pattern.spectrum(); ++c) {
-                patternKey += std::to_string(pattern(x, y, 0, c)) + ",";
-            }
-        }
-    }
-    return patternKey;
-}
-
 void WFC::Analyzer::calculateProbabilities() {
     //calculate sum of all frequencies
-    sumFrequency = std::accumulate(patternFrequency.begin(), patternFrequency.end(), 0.0,
-                                   [](double acc, const auto &p) {
-                                       return acc + p.second;
-                                   });
+    sumFrequency = std::accumulate(patternFrequencies.begin(), patternFrequencies.end(), 0.0);
 
     //resize the probabilities vector to match the size of the patterns vector
-    probabilities.resize(patterns.size());
+    probabilities.resize(getPatternCount());
 
     //calculate probabilities for each pattern
-    for (size_t i = 0; i < patterns.size(); ++i) {
-        std::string patternStr = patternToStr(patterns[i]);
-        double frequency = patternFrequency[patternStr];
+    for (size_t i = 0; i < getPatternCount(); ++i) {
+        double frequency = patternFrequencies[i];
         double probability = frequency / sumFrequency;
         probabilities[i] = probability;
     }
@@ -207,19 +312,17 @@ void WFC::Analyzer::savePatternsPreviewTo(const std::string &path) {
     auto generatedPatternsImage = cimg::CImg<unsigned char>(imageSizeWithSpaceX, imageSizeWithSpaceY, 1, 3, 0);
     unsigned char color[] = {0, 0, 0}; // white color for the grid
     generatedPatternsImage.fill(128, 128, 128);
-    for (size_t i = 0; i < patterns.size(); i++) {
+    for (size_t i = 0; i < getPatternCount(); i++) {
         size_t row = i / cols;
         size_t col = i % cols;
-        //need to make copy, resize will modify original pattern
-        cimg::CImg<unsigned char> resizedPattern = patterns[i].get_resize(scaledPatternSize, scaledPatternSize);
+        cimg::CImg<unsigned char> resizedPattern = patternToImage(i).get_resize(scaledPatternSize, scaledPatternSize);
         generatedPatternsImage.draw_image(sb + (row * scaledPatternSize) + (sb * row),
                                           sb + (col * scaledPatternSize) + (sb * col),
                                           resizedPattern);
 
         std::stringstream ss;
-        std::string patternStr = patternToStr(patterns.at(i));
         ss << "#:" << std::to_string(i) <<
-           " F:" << std::to_string(patternFrequency[patternStr]) <<
+           " F:" << std::to_string(patternFrequencies.at(i)) <<
            " P:" << std::fixed << std::setprecision(2) << probabilities.at(i) * 100 << "%%";
 
         generatedPatternsImage.draw_text(sb + (row * scaledPatternSize) + (sb * row),
@@ -233,10 +336,9 @@ void WFC::Analyzer::savePatternsPreviewTo(const std::string &path) {
         for (size_t col = 0; col < cols; col++) {
             for (size_t i = 0; i <= options.patternSize; i++) {
                 size_t patternIndex = row * cols + col;
-                if (patternIndex >= patterns.size()) {
+                if (patternIndex >= getPatternCount()) {
                     continue;
                 }
-                cimg::CImg<unsigned char> pattern = patterns[row * cols + col];
 
                 size_t gridOffset = i * options.previewImgScale;
                 generatedPatternsImage.draw_line(sb + (row * scaledPatternSize) + (sb * row),
@@ -259,7 +361,7 @@ void WFC::Analyzer::savePatternsPreviewTo(const std::string &path) {
 }
 
 std::tuple<size_t, size_t> WFC::Analyzer::getPatternGridSize() {
-    size_t patternsSize = patterns.size();
+    size_t patternsSize = getPatternCount();
     auto sqrtPatternsCount = static_cast<unsigned int>(std::sqrt(patternsSize));
     unsigned int rows = sqrtPatternsCount;
     unsigned int cols = sqrtPatternsCount;
@@ -277,8 +379,42 @@ const WFC::AnalyzerOptions &WFC::Analyzer::getOptions() const {
     return options;
 }
 
-const std::vector<cimg::CImg<unsigned char>> &WFC::Analyzer::getPatterns() const {
-    return patterns;
+size_t WFC::Analyzer::getPatternCount() const {
+    return patternTable.size();
+}
+
+const uint8_t *WFC::Analyzer::getPattern(size_t pattern) const {
+    return patternTable.key(pattern);
+}
+
+size_t WFC::Analyzer::getPatternIndex(size_t pattern, int x, int y) const {
+    return Palette::readIndex(getPattern(pattern), y * options.patternSize + x, indexBytes);
+}
+
+size_t WFC::Analyzer::getCanonicalPattern(size_t pattern) const {
+    return canonicalPatterns[pattern];
+}
+
+uint8_t WFC::Analyzer::getPatternTransform(size_t pattern) const {
+    return patternTransforms[pattern];
+}
+
+const WFC::Palette &WFC::Analyzer::getPalette() const {
+    return palette;
+}
+
+cimg::CImg<unsigned char> WFC::Analyzer::patternToImage(size_t pattern) const {
+    int size = static_cast<int>(options.patternSize);
+    cimg::CImg<unsigned char> image(size, size, 1, palette.getSpectrum());
+    for (int y = 0; y < size; y++) {
+        for (int x = 0; x < size; x++) {
+            const uint8_t *color = palette.color(getPatternIndex(pattern, x, y));
+            for (int c = 0; c < palette.getSpectrum(); c++) {
+                image(x, y, 0, c) = color[c];
+            }
+        }
+    }
+    return image;
 }
 
 const std::vector<double>& WFC::Analyzer::getProbabilities() const {
@@ -299,9 +435,8 @@ void WFC::Analyzer::LogProbabilities() {
     Util::Logger::log(Util::LogLevel::Debug, "Sum of all probabilities: " + std::to_string(sum));
 
     //match pattern to its probability and print it via Logger
-    for (size_t i = 0; i < patterns.size(); ++i) {
-        std::string patternStr = patternToStr(patterns[i]);
-        Util::Logger::log(Util::LogLevel::Debug, "Pattern " + patternStr + " has probability: " +
+    for (size_t i = 0; i < getPatternCount(); ++i) {
+        Util::Logger::log(Util::LogLevel::Debug, "Pattern " + std::to_string(i) + " has probability: " +
                                      std::to_string(probabilities[i]));
     }
 }
@@ -9,6 +9,7 @@
 #include <set>
 #include <numeric>
 #include <iomanip>
+#include <memory>
 
 //CImg configuration
 #define cimg_use_png
@@ -19,6 +20,11 @@
 #include "../utility/Timer.h"
 #include "../utility/Point.h"
 #include "../utility/FileUtil.h"
+#include "../utility/ThreadPool.h"
+#include "PatternTable.h"
+#include "Palette.h"
+#include "RollingHash.h"
+#include "Symmetry.h"
 
 namespace cimg = cimg_library;
 
@@ -30,6 +36,8 @@ namespace WFC {
         int spaceBetween;
         bool rotate;
         bool flip;
+        //threads used for extraction
+        size_t threads;
     };
 
     using Rules = std::vector<std::unordered_map<Util::Point, std::set<size_t>, Util::PointHash>>;
@@ -43,7 +51,21 @@ namespace WFC {
 
         const AnalyzerOptions &getOptions() const;
 
-        const std::vector<cimg::CImg<unsigned char>> &getPatterns() const;
+        size_t getPatternCount() const;
+
+        //palette indices of the pattern, row by row with getIndexBytes() bytes per index
+        const uint8_t *getPattern(size_t pattern) const;
+
+        //palette index at x, y of the pattern
+        size_t getPatternIndex(size_t pattern, int x, int y) const;
+
+        //pattern with the smallest indices among the rotations and mirrors of this one
+        size_t getCanonicalPattern(size_t pattern) const;
+
+        //transform that turns the canonical pattern into this one
+        uint8_t getPatternTransform(size_t pattern) const;
+
+        const Palette &getPalette() const;
 
         void savePatternsPreviewTo(const std::string &path);
 
@@ -56,23 +78,38 @@ namespace WFC {
         void setOptions(const AnalyzerOptions &options);
 
     private:
+        //patterns found in one band of window rows, kept apart until all bands are merged in order
+        struct PatternBand {
+            PatternTable table;
+            std::vector<int> frequencies;
+            size_t windows = 0;
+        };
+
+        void buildIndexImage();
+
         void generatePatterns();
 
+        void findSymmetryClasses(const std::vector<uint8_t> &transforms);
+
+        //adds every window whose top row is in [firstRow, endRow) to the band, once for each transform
+        void extractBand(size_t firstRow, size_t endRow, const std::vector<uint8_t> &transforms,
+                         PatternBand &band) const;
+
+        //compares the pattern with a window directly in the index image, element i of the window is at
+        //window + elementOffsets[i]
+        bool windowMatches(const uint8_t *pattern, const uint8_t *window, const size_t *elementOffsets) const;
+
         void generateOffsets();
 
         void generateRules();
 
         void logRules();
 
-        void addPattern(const cimg::CImg<unsigned char> &pattern);
-
-        bool
-        checkForMatch(const cimg::CImg<unsigned char> &p1, const cimg::CImg<unsigned char> &p2,
-                      const Util::Point &offset) const;
+        bool checkForMatch(const uint8_t *p1, const uint8_t *p2, const Util::Point &offset) const;
 
-        cimg::CImg<unsigned char> maskWithOffset(const cimg::CImg<unsigned char> &pattern, const Util::Point &offset) const;
+        std::vector<uint8_t> maskWithOffset(const uint8_t *pattern, const Util::Point &offset) const;
 
-        std::string patternToStr(const cimg::CImg<unsigned char> &pattern) const;
+        cimg::CImg<unsigned char> patternToImage(size_t pattern) const;
 
         void calculateProbabilities();
 
@@ -87,15 +124,26 @@ namespace WFC {
         //input image patterns are extracted from
         const cimg::CImg<unsigned char> &getInputImage() const;
 
-        //vector of unique extracted from input image
-        std::vector<cimg::CImg<unsigned char>> patterns;
-        //map to store frequency of each pattern
-        std::unordered_map<std::string, int> patternFrequency;
+        //colours of the input image
+        Palette palette;
+        //input image as palette indices, row by row with indexBytes bytes per pixel
+        std::vector<uint8_t> indexImage;
+        size_t indexBytes = 1;
+        //unique patterns extracted from input image as palette indices, the id of a pattern is its index
+        PatternTable patternTable;
+        //how many times each pattern was found, indexed by pattern id
+        std::vector<int> patternFrequencies;
+        //permutation tables of the rotations and mirrors for the pattern size
+        Symmetry symmetry;
+        //every pattern is patternTransforms[i] applied to canonicalPatterns[i]
+        std::vector<size_t> canonicalPatterns;
+        std::vector<uint8_t> patternTransforms;
         //vector of all patterns that store map of their offsets with possible neighbors at that offset
         Rules rules;
         //vector of all offsets
         std::vector<Util::Point> offsets;
         double sumFrequency{};
+        std::unique_ptr<Util::ThreadPool> threadPool;
         std::vector<double> probabilities;
     };
 }
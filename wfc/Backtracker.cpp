@@ -50,6 +50,10 @@ void WFC::Backtracker::setOptions(const BacktrackerOptions &options) {
     this->options = options;
 }
 
+const WFC::BacktrackerOptions &WFC::Backtracker::getOptions() const {
+    return options;
+}
+
 bool WFC::Backtracker::isAbleToBacktrack() const {
     return !states.empty();
 }
@@ -92,11 +96,12 @@ void WFC::Backtracker::setLastIteration(size_t lastIteration) {
 
 void WFC::Backtracker::logStates() const {
     for (const auto &state: states) {
-        for (const auto &row: state.first.state) {
-            for (const auto &cell: row) {
-                std::cout << cell.size() << " ";
+        const Wave &wave = state.first.state;
+        for (size_t cell = 0; cell < wave.getCellCount(); cell++) {
+            std::cout << wave.count(cell) << " ";
+            if ((cell + 1) % wave.getWidth() == 0) {
+                std::cout << std::endl;
             }
-            std::cout << std::endl;
         }
         std::cout << std::endl;
     }
@@ -12,10 +12,11 @@
 #include <iostream>
 
 #include "../utility/Logger.h"
+#include "Wave.h"
 
 namespace WFC {
 
-    using imageState = std::vector<std::vector<std::vector<bool>>>;
+    using imageState = Wave;
     using collapsedState = std::vector<std::vector<int>>;
 
     struct State {
@@ -51,6 +52,8 @@ namespace WFC {
 
         void setOptions(const BacktrackerOptions &options);
 
+        [[nodiscard]] const BacktrackerOptions &getOptions() const;
+
         void setBacktracking(bool backtracking);
 
         [[nodiscard]] bool isBacktracking() const;
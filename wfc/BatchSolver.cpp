@@ -0,0 +1,390 @@
+//
+// Created on 18.10.2026.
+//
+
+#include "BatchSolver.h"
+
+WFC::BatchSolver::BatchSolver(const Analyzer &analyzer, size_t width, size_t height) :
+        analyzer(analyzer),
+        width(width),
+        height(height),
+        patternCount(analyzer.getPatternCount()),
+        wordsPerCell((patternCount + 63) / 64) {
+    const auto &offsets = analyzer.getOffsets();
+    const auto &rules = analyzer.getRules();
+
+    //precompute wrapped neighbours, outputs are small so the table is cheap
+    neighbours.resize(width * height * offsets.size());
+    for (size_t cell = 0; cell < width * height; cell++) {
+        int x = static_cast<int>(cell % width);
+        int y = static_cast<int>(cell / width);
+        for (size_t o = 0; o < offsets.size(); o++) {
+            int nx = (x + offsets[o].x + static_cast<int>(width)) % static_cast<int>(width);
+            int ny = (y + offsets[o].y + static_cast<int>(height)) % static_cast<int>(height);
+            neighbours[cell * offsets.size() + o] = static_cast<size_t>(ny) * width + static_cast<size_t>(nx);
+        }
+    }
+
+    //invert the rules, pattern j at offset o is supported by every pattern i that has j in rules[i][o]
+    std::vector<std::vector<uint32_t>> supportLists(offsets.size() * patternCount);
+    for (size_t i = 0; i < patternCount; i++) {
+        for (size_t o = 0; o < offsets.size(); o++) {
+            auto it = rules[i].find(offsets[o]);
+            if (it == rules[i].end()) {
+                continue;
+            }
+            for (size_t j: it->second) {
+                supportLists[o * patternCount + j].push_back(static_cast<uint32_t>(i));
+            }
+        }
+    }
+    supportStarts.reserve(supportLists.size() + 1);
+    supportStarts.push_back(0);
+    for (const auto &list: supportLists) {
+        supporters.insert(supporters.end(), list.begin(), list.end());
+        supportStarts.push_back(supporters.size());
+    }
+    averageRow = static_cast<double>(supporters.size()) /
+                 static_cast<double>(std::max<size_t>(1, patternCount * offsets.size()));
+
+    for (double weight: analyzer.getProbabilities()) {
+        weightLogWeights.push_back(weight * std::log(weight));
+    }
+
+    //every lane starts from the same state, so the full wave is propagated once for a single lane and a reset lane
+    //gets a copy of it instead of propagating every cell again
+    Lanes fresh;
+    fresh.wave.assign(width * height * patternCount, 1);
+    fresh.laneWave.assign(lanes * width * height * wordsPerCell, 0);
+    fresh.changed.assign(width * height, 1);
+    fresh.active = 1;
+    for (size_t cell = 0; cell < width * height; cell++) {
+        for (size_t pattern = 0; pattern < patternCount; pattern++) {
+            laneCell(fresh, 0, cell)[pattern / 64] |= uint64_t{1} << (pattern % 64);
+        }
+    }
+    std::vector<size_t> allCells(width * height);
+    std::iota(allCells.begin(), allCells.end(), 0);
+    propagate(fresh, allCells);
+    initialWave.resize(fresh.wave.size());
+    for (size_t i = 0; i < fresh.wave.size(); i++) {
+        initialWave[i] = (fresh.wave[i] & 1) ? ~uint64_t{0} : 0;
+    }
+    const uint64_t *firstLane = laneCell(fresh, 0, 0);
+    initialLane.assign(firstLane, firstLane + width * height * wordsPerCell);
+}
+
+void WFC::BatchSolver::solve(std::atomic<size_t> &nextJob, const std::vector<uint64_t> &jobSeeds, size_t attempts,
+                             std::vector<cimg::CImg<unsigned char>> &outputs) const {
+    Lanes batch;
+    batch.wave.assign(width * height * patternCount, 0);
+    batch.laneWave.assign(lanes * width * height * wordsPerCell, 0);
+    batch.changed.assign(width * height, 0);
+    batch.jobs.assign(lanes, 0);
+    batch.attempts.assign(lanes, 0);
+    batch.rngs.resize(lanes);
+    for (size_t lane = 0; lane < lanes; lane++) {
+        refill(batch, lane, nextJob, jobSeeds);
+    }
+
+    while (batch.active) {
+        uint64_t finished = 0;
+        std::vector<size_t> chosenCells = observe(batch, finished);
+        uint64_t collapsing = batch.active & ~finished & ~batch.dead;
+
+        for (size_t lane = 0; lane < lanes; lane++) {
+            uint64_t bit = uint64_t{1} << lane;
+            if (finished & bit) {
+                outputs[batch.jobs[lane]] = extractOutput(batch, lane);
+                refill(batch, lane, nextJob, jobSeeds);
+            } else if (batch.dead & bit) {
+                //restart the same job from a stream of its own, how much of the old stream the contradicted
+                //state used depends on what else was propagated in the same step
+                if (++batch.attempts[lane] < attempts) {
+                    batch.rngs[lane] = Util::Random::makeGenerator(
+                            Util::Random::splitSeed(jobSeeds[batch.jobs[lane]], batch.attempts[lane]));
+                    resetLane(batch, lane);
+                } else {
+                    Util::Logger::log(Util::LogLevel::Warning,
+                                      "Batch job " + std::to_string(batch.jobs[lane]) + " gave up after " +
+                                      std::to_string(attempts) + " contradictions");
+                    refill(batch, lane, nextJob, jobSeeds);
+                }
+            }
+        }
+        batch.dead = 0;
+
+        std::vector<size_t> startCells;
+        for (size_t lane = 0; lane < lanes; lane++) {
+            if (collapsing & (uint64_t{1} << lane)) {
+                collapse(batch, lane, chosenCells[lane]);
+                startCells.push_back(chosenCells[lane]);
+            }
+        }
+        propagate(batch, startCells);
+    }
+}
+
+void WFC::BatchSolver::refill(Lanes &batch, size_t lane, std::atomic<size_t> &nextJob,
+                              const std::vector<uint64_t> &jobSeeds) const {
+    uint64_t bit = uint64_t{1} << lane;
+    size_t job = nextJob.fetch_add(1);
+    if (job >= jobSeeds.size()) {
+        batch.active &= ~bit;
+        for (auto &word: batch.wave) {
+            word &= ~bit;
+        }
+        std::fill(laneCell(batch, lane, 0), laneCell(batch, lane, width * height), 0);
+        return;
+    }
+    batch.jobs[lane] = job;
+    batch.attempts[lane] = 0;
+    batch.rngs[lane] = Util::Random::makeGenerator(jobSeeds[job]);
+    batch.active |= bit;
+    resetLane(batch, lane);
+}
+
+void WFC::BatchSolver::resetLane(Lanes &batch, size_t lane) const {
+    //one word per cell and pattern, so every word gets the lane bit of the propagated start state, which does not
+    //depend on the other lanes
+    uint64_t bit = uint64_t{1} << lane;
+    for (size_t i = 0; i < batch.wave.size(); i++) {
+        batch.wave[i] = (batch.wave[i] & ~bit) | (initialWave[i] & bit);
+    }
+    std::copy(initialLane.begin(), initialLane.end(), laneCell(batch, lane, 0));
+    //the start state needs no propagation, changes left over from the old job would only be checked for nothing
+    for (auto &changedLanes: batch.changed) {
+        changedLanes &= ~bit;
+    }
+}
+
+std::vector<size_t> WFC::BatchSolver::observe(Lanes &batch, uint64_t &finished) const {
+    const auto &probabilities = analyzer.getProbabilities();
+    size_t cellCount = width * height;
+    std::vector<size_t> minCells(lanes, cellCount);
+    std::vector<double> minEntropies(lanes, std::numeric_limits<double>::max());
+    std::vector<size_t> ties(lanes, 0);
+    std::vector<double> sumWeights(lanes);
+    std::vector<double> sumLogWeights(lanes);
+    std::vector<size_t> counts(lanes);
+
+    for (size_t cell = 0; cell < cellCount; cell++) {
+        std::fill(sumWeights.begin(), sumWeights.end(), 0.0);
+        std::fill(sumLogWeights.begin(), sumLogWeights.end(), 0.0);
+        std::fill(counts.begin(), counts.end(), 0);
+        const uint64_t *cellWords = batch.wave.data() + cell * patternCount;
+        for (size_t pattern = 0; pattern < patternCount; pattern++) {
+            uint64_t bits = cellWords[pattern] & batch.active;
+            while (bits) {
+                auto lane = static_cast<size_t>(__builtin_ctzll(bits));
+                sumWeights[lane] += probabilities[pattern];
+                sumLogWeights[lane] += weightLogWeights[pattern];
+                counts[lane]++;
+                bits &= bits - 1;
+            }
+        }
+
+        uint64_t activeLanes = batch.active & ~batch.dead;
+        while (activeLanes) {
+            auto lane = static_cast<size_t>(__builtin_ctzll(activeLanes));
+            activeLanes &= activeLanes - 1;
+            if (counts[lane] == 0) {
+                batch.dead |= uint64_t{1} << lane;
+                continue;
+            }
+            if (counts[lane] == 1) {
+                continue;
+            }
+            double entropy = std::log(sumWeights[lane]) - (sumLogWeights[lane] / sumWeights[lane]);
+            //cells with the same entropy are picked uniformly, one at a time as they are found
+            if (entropy < minEntropies[lane]) {
+                minEntropies[lane] = entropy;
+                minCells[lane] = cell;
+                ties[lane] = 1;
+            } else if (entropy == minEntropies[lane]) {
+                ties[lane]++;
+                std::uniform_int_distribution<size_t> dist(0, ties[lane] - 1);
+                if (dist(batch.rngs[lane]) == 0) {
+                    minCells[lane] = cell;
+                }
+            }
+        }
+    }
+
+    finished = 0;
+    for (size_t lane = 0; lane < lanes; lane++) {
+        uint64_t bit = uint64_t{1} << lane;
+        if ((batch.active & bit) && !(batch.dead & bit) && minCells[lane] == cellCount) {
+            finished |= bit;
+        }
+    }
+    return minCells;
+}
+
+void WFC::BatchSolver::collapse(Lanes &batch, size_t lane, size_t cell) const {
+    uint64_t bit = uint64_t{1} << lane;
+    uint64_t *cellWords = batch.wave.data() + cell * patternCount;
+    std::vector<double> probabilities(patternCount, 0.0);
+    for (size_t pattern = 0; pattern < patternCount; pattern++) {
+        if (cellWords[pattern] & bit) {
+            probabilities[pattern] = analyzer.getProbabilities()[pattern];
+        }
+    }
+    std::discrete_distribution<size_t> dist(probabilities.begin(), probabilities.end());
+    size_t chosenPattern = dist(batch.rngs[lane]);
+    for (size_t pattern = 0; pattern < patternCount; pattern++) {
+        if (pattern != chosenPattern) {
+            cellWords[pattern] &= ~bit;
+        }
+    }
+    uint64_t *laneWords = laneCell(batch, lane, cell);
+    std::fill(laneWords, laneWords + wordsPerCell, 0);
+    laneWords[chosenPattern / 64] = uint64_t{1} << (chosenPattern % 64);
+    batch.changed[cell] |= bit;
+}
+
+void WFC::BatchSolver::propagate(Lanes &batch, const std::vector<size_t> &startCells) const {
+    size_t offsetCount = analyzer.getOffsets().size();
+    std::vector<char> queued(width * height, false);
+    std::deque<size_t> propagationQueue;
+    for (size_t cell: startCells) {
+        if (!queued[cell]) {
+            queued[cell] = true;
+            propagationQueue.push_back(cell);
+        }
+    }
+
+    std::vector<uint64_t> mask(wordsPerCell);
+    //lanes that are not running or already ran out of patterns somewhere are left as they are
+    uint64_t settled = ~batch.active | batch.dead;
+    while (!propagationQueue.empty()) {
+        size_t currentCell = propagationQueue.front();
+        propagationQueue.pop_front();
+        queued[currentCell] = false;
+        const uint64_t *currentWords = batch.wave.data() + currentCell * patternCount;
+        //neighbours already agree with this cell in the lanes where it did not change, usually one lane does
+        uint64_t checked = batch.changed[currentCell] & ~settled;
+        batch.changed[currentCell] = 0;
+
+        //a lane costs the rows of its few patterns in the cell, all lanes together cost the supporters of every
+        //pattern, so the lanes are updated one by one unless most of them changed
+        if (static_cast<double>(__builtin_popcountll(checked)) * 2.0 <= averageRow) {
+            while (checked) {
+                auto lane = static_cast<size_t>(__builtin_ctzll(checked));
+                checked &= checked - 1;
+                if (!propagateLane(batch, currentCell, lane, queued, propagationQueue, mask)) {
+                    settled |= uint64_t{1} << lane;
+                }
+            }
+            continue;
+        }
+
+        for (size_t o = 0; o < offsetCount; o++) {
+            size_t neighbourCell = neighbours[currentCell * offsetCount + o];
+            uint64_t *neighbourWords = batch.wave.data() + neighbourCell * patternCount;
+            bool changed = false;
+            uint64_t alive = 0;
+            for (size_t pattern = 0; pattern < patternCount; pattern++) {
+                uint64_t old = neighbourWords[pattern];
+                if ((old & checked) == 0) {
+                    alive |= old;
+                    continue;
+                }
+                //lanes where any pattern of the current cell allows this pattern at the offset
+                uint64_t support = 0;
+                size_t supportEnd = supportStarts[o * patternCount + pattern + 1];
+                for (size_t s = supportStarts[o * patternCount + pattern]; s < supportEnd; s++) {
+                    support |= currentWords[supporters[s]];
+                }
+                uint64_t updated = old & (support | ~checked);
+                if (updated != old) {
+                    neighbourWords[pattern] = updated;
+                    batch.changed[neighbourCell] |= old ^ updated;
+                    changed = true;
+                    for (uint64_t removed = old ^ updated; removed; removed &= removed - 1) {
+                        laneCell(batch, static_cast<size_t>(__builtin_ctzll(removed)), neighbourCell)[pattern / 64] &=
+                                ~(uint64_t{1} << (pattern % 64));
+                    }
+                }
+                alive |= updated;
+            }
+
+            //a lane with no pattern left is dead, observe retires it and it is not propagated any further
+            settled |= batch.active & ~alive;
+            if (changed && !queued[neighbourCell]) {
+                queued[neighbourCell] = true;
+                propagationQueue.push_back(neighbourCell);
+            }
+        }
+    }
+}
+
+bool WFC::BatchSolver::propagateLane(Lanes &batch, size_t cell, size_t lane, std::vector<char> &queued,
+                                     std::deque<size_t> &propagationQueue, std::vector<uint64_t> &mask) const {
+    const auto &offsets = analyzer.getOffsets();
+    const auto &rules = analyzer.getRules();
+    uint64_t bit = uint64_t{1} << lane;
+    const uint64_t *currentBits = laneCell(batch, lane, cell);
+
+    for (size_t o = 0; o < offsets.size(); o++) {
+        //patterns allowed at the offset by any pattern of the cell, as the single solver collects them
+        std::fill(mask.begin(), mask.end(), 0);
+        for (size_t word = 0; word < wordsPerCell; word++) {
+            for (uint64_t patterns = currentBits[word]; patterns; patterns &= patterns - 1) {
+                size_t pattern = word * 64 + static_cast<size_t>(__builtin_ctzll(patterns));
+                auto it = rules[pattern].find(offsets[o]);
+                if (it == rules[pattern].end()) {
+                    continue;
+                }
+                for (size_t possiblePattern: it->second) {
+                    mask[possiblePattern / 64] |= uint64_t{1} << (possiblePattern % 64);
+                }
+            }
+        }
+
+        size_t neighbourCell = neighbours[cell * offsets.size() + o];
+        uint64_t *neighbourBits = laneCell(batch, lane, neighbourCell);
+        uint64_t *neighbourWords = batch.wave.data() + neighbourCell * patternCount;
+        bool changed = false;
+        bool alive = false;
+        for (size_t word = 0; word < wordsPerCell; word++) {
+            uint64_t removed = neighbourBits[word] & ~mask[word];
+            neighbourBits[word] &= mask[word];
+            alive = alive || neighbourBits[word];
+            //the bit sliced wave loses the same patterns, one word per removed pattern
+            for (changed = changed || removed; removed; removed &= removed - 1) {
+                neighbourWords[word * 64 + static_cast<size_t>(__builtin_ctzll(removed))] &= ~bit;
+            }
+        }
+        if (!alive) {
+            return false;
+        }
+        if (changed) {
+            batch.changed[neighbourCell] |= bit;
+            if (!queued[neighbourCell]) {
+                queued[neighbourCell] = true;
+                propagationQueue.push_back(neighbourCell);
+            }
+        }
+    }
+    return true;
+}
+
+cimg::CImg<unsigned char> WFC::BatchSolver::extractOutput(const Lanes &batch, size_t lane) const {
+    uint64_t bit = uint64_t{1} << lane;
+    const auto &palette = analyzer.getPalette();
+    cimg::CImg<unsigned char> res(width, height, 1, 3, 0);
+    for (size_t cell = 0; cell < width * height; cell++) {
+        const uint64_t *cellWords = batch.wave.data() + cell * patternCount;
+        for (size_t pattern = 0; pattern < patternCount; pattern++) {
+            if (cellWords[pattern] & bit) {
+                const uint8_t *color = palette.color(analyzer.getPatternIndex(pattern, 0, 0));
+                for (int c = 0; c < 3; c++) {
+                    res(cell % width, cell / width, 0, c) = color[std::min(c, palette.getSpectrum() - 1)];
+                }
+                break;
+            }
+        }
+    }
+    return res;
+}
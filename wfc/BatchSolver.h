@@ -0,0 +1,101 @@
+//
+// Created on 18.10.2026.
+//
+
+#ifndef WFC_BATCHSOLVER_H
+#define WFC_BATCHSOLVER_H
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <random>
+#include <vector>
+
+#include "Analyzer.h"
+#include "../utility/Random.h"
+
+namespace WFC {
+
+    struct BatchOptions {
+        //number of outputs to generate
+        size_t count;
+        //how many times a job is restarted after a contradiction before it is given up
+        size_t attempts;
+    };
+
+    //solves many small outputs at once, every output is one bit lane of a bit sliced wave,
+    //so one propagation step updates all of them with the same bitwise operations
+    class BatchSolver {
+    public:
+        static constexpr size_t lanes = 64;
+
+        BatchSolver(const Analyzer &analyzer, size_t width, size_t height);
+
+        //takes jobs from nextJob until all are taken, can be called from multiple threads at once,
+        //each job only uses its own seed so the outputs do not depend on which lane or thread solves it
+        void solve(std::atomic<size_t> &nextJob, const std::vector<uint64_t> &jobSeeds, size_t attempts,
+                   std::vector<cimg::CImg<unsigned char>> &outputs) const;
+
+    private:
+        //state of up to 64 jobs solved in lockstep
+        struct Lanes {
+            //wave[cell * patternCount + pattern] has bit l set if pattern is possible in that cell of lane l
+            std::vector<uint64_t> wave;
+            //the same bits lane major, laneWave[(lane * cellCount + cell) * wordsPerCell + word] has bit b set if
+            //pattern word * 64 + b is possible in that cell of the lane, so one lane is updated a word at a time
+            std::vector<uint64_t> laneWave;
+            //lanes in which the patterns of a cell changed since the cell was last propagated, only these lanes can
+            //remove patterns from its neighbours
+            std::vector<uint64_t> changed;
+            std::vector<size_t> jobs;
+            std::vector<size_t> attempts;
+            std::vector<std::mt19937> rngs;
+            uint64_t active = 0;
+            //lanes that hit a contradiction in this step, they are no longer updated by propagation
+            uint64_t dead = 0;
+        };
+
+        void refill(Lanes &batch, size_t lane, std::atomic<size_t> &nextJob, const std::vector<uint64_t> &jobSeeds) const;
+
+        void resetLane(Lanes &batch, size_t lane) const;
+
+        //picks the lowest entropy cell of every active lane, returns cell count for lanes with nothing to collapse
+        std::vector<size_t> observe(Lanes &batch, uint64_t &finished) const;
+
+        void collapse(Lanes &batch, size_t lane, size_t cell) const;
+
+        void propagate(Lanes &batch, const std::vector<size_t> &startCells) const;
+
+        //updates the neighbours of the cell in one lane from the lane major bits, which beats the bit sliced update
+        //when few lanes changed. returns false if the lane ran out of patterns somewhere
+        bool propagateLane(Lanes &batch, size_t cell, size_t lane, std::vector<char> &queued,
+                           std::deque<size_t> &propagationQueue, std::vector<uint64_t> &mask) const;
+
+        [[nodiscard]] uint64_t *laneCell(Lanes &batch, size_t lane, size_t cell) const {
+            return batch.laneWave.data() + (lane * width * height + cell) * wordsPerCell;
+        }
+
+        cimg::CImg<unsigned char> extractOutput(const Lanes &batch, size_t lane) const;
+
+    private:
+        const Analyzer &analyzer;
+        size_t width;
+        size_t height;
+        size_t patternCount;
+        size_t wordsPerCell;
+        //neighbour cell of every cell at every offset, wrapped around the output
+        std::vector<size_t> neighbours;
+        //patterns in a cell that allow pattern j at offset o, supporters[supportStarts[o * P + j]...]
+        std::vector<size_t> supportStarts;
+        std::vector<uint32_t> supporters;
+        //average number of neighbours of a pattern at an offset, the cost of the support of one pattern for all lanes
+        double averageRow;
+        std::vector<double> weightLogWeights;
+        //the full wave propagated to its fixpoint, every bit of a word is set if the pattern is possible in the cell
+        std::vector<uint64_t> initialWave;
+        //one lane of initialWave, lane major
+        std::vector<uint64_t> initialLane;
+    };
+}
+
+#endif //WFC_BATCHSOLVER_H
@@ -0,0 +1,33 @@
+//
+// Created on 18.10.2026.
+//
+
+#include "Palette.h"
+
+#include <string>
+
+WFC::Palette::Palette(int spectrum) : spectrum(spectrum), colors(static_cast<size_t>(spectrum)) {}
+
+size_t WFC::Palette::indexOf(const uint8_t *color) {
+    auto [index, inserted] = colors.insert(color);
+    if (inserted && index >= maxColors) {
+        throw std::runtime_error("Input has more than " + std::to_string(maxColors) + " distinct colors");
+    }
+    return index;
+}
+
+const uint8_t *WFC::Palette::color(size_t index) const {
+    return colors.key(index);
+}
+
+size_t WFC::Palette::size() const {
+    return colors.size();
+}
+
+int WFC::Palette::getSpectrum() const {
+    return spectrum;
+}
+
+size_t WFC::Palette::getIndexBytes() const {
+    return colors.size() <= 256 ? 1 : 2;
+}
@@ -0,0 +1,59 @@
+//
+// Created on 18.10.2026.
+//
+
+#ifndef WFC_PALETTE_H
+#define WFC_PALETTE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+
+#include "PatternTable.h"
+
+namespace WFC {
+
+    //distinct colours of the input, patterns store indices into it instead of pixels
+    class Palette {
+    public:
+        static constexpr size_t maxColors = 65536;
+
+        explicit Palette(int spectrum = 3);
+
+        //index of the colour, the colour is added if it was not seen before
+        size_t indexOf(const uint8_t *color);
+
+        //spectrum bytes of the colour at index
+        [[nodiscard]] const uint8_t *color(size_t index) const;
+
+        [[nodiscard]] size_t size() const;
+
+        [[nodiscard]] int getSpectrum() const;
+
+        //1 while every index fits into a byte, 2 otherwise
+        [[nodiscard]] size_t getIndexBytes() const;
+
+        //element of an index array stored with indexBytes bytes per index
+        static size_t readIndex(const uint8_t *data, size_t element, size_t indexBytes) {
+            if (indexBytes == 1) {
+                return data[element];
+            }
+            return static_cast<size_t>(data[element * 2]) | (static_cast<size_t>(data[element * 2 + 1]) << 8);
+        }
+
+        static void writeIndex(uint8_t *data, size_t element, size_t indexBytes, size_t index) {
+            if (indexBytes == 1) {
+                data[element] = static_cast<uint8_t>(index);
+                return;
+            }
+            data[element * 2] = static_cast<uint8_t>(index);
+            data[element * 2 + 1] = static_cast<uint8_t>(index >> 8);
+        }
+
+    private:
+        int spectrum;
+        PatternTable colors;
+    };
+}
+
+#endif //WFC_PALETTE_H
@@ -0,0 +1,78 @@
+//
+// Created on 18.10.2026.
+//
+
+#include "PatternTable.h"
+
+#include <algorithm>
+
+WFC::PatternTable::PatternTable(size_t keySize) : keySize(keySize) {}
+
+std::pair<size_t, bool> WFC::PatternTable::insert(const uint8_t *key) {
+    return insert(key, hashKey(key));
+}
+
+std::pair<size_t, bool> WFC::PatternTable::insert(const uint8_t *key, uint64_t hash) {
+    size_t existing = find(hash, [&](size_t id) {
+        return std::memcmp(this->key(id), key, keySize) == 0;
+    });
+    if (existing != npos) {
+        return {existing, false};
+    }
+
+    //keep the load factor under one half so probe chains stay short
+    if ((hashes.size() + 1) * 2 > slots.size()) {
+        grow();
+    }
+    size_t id = hashes.size();
+    keys.insert(keys.end(), key, key + keySize);
+    hashes.push_back(hash);
+    placeId(id);
+    return {id, true};
+}
+
+size_t WFC::PatternTable::find(const uint8_t *key) const {
+    return find(hashKey(key), [&](size_t id) {
+        return std::memcmp(this->key(id), key, keySize) == 0;
+    });
+}
+
+size_t WFC::PatternTable::size() const {
+    return hashes.size();
+}
+
+size_t WFC::PatternTable::getKeySize() const {
+    return keySize;
+}
+
+const uint8_t *WFC::PatternTable::key(size_t id) const {
+    return keys.data() + id * keySize;
+}
+
+uint64_t WFC::PatternTable::hashOf(size_t id) const {
+    return hashes[id];
+}
+
+const std::vector<uint8_t> &WFC::PatternTable::getKeys() const {
+    return keys;
+}
+
+uint64_t WFC::PatternTable::hashKey(const uint8_t *key) const {
+    return Util::Hash::bytes(key, keySize);
+}
+
+void WFC::PatternTable::placeId(size_t id) {
+    size_t mask = slots.size() - 1;
+    size_t slot = Util::Hash::mix(hashes[id]) & mask;
+    while (slots[slot] != 0) {
+        slot = (slot + 1) & mask;
+    }
+    slots[slot] = static_cast<uint32_t>(id + 1);
+}
+
+void WFC::PatternTable::grow() {
+    slots.assign(std::max<size_t>(64, slots.size() * 2), 0);
+    for (size_t id = 0; id < hashes.size(); id++) {
+        placeId(id);
+    }
+}
@@ -0,0 +1,80 @@
+//
+// Created on 18.10.2026.
+//
+
+#ifndef WFC_PATTERNTABLE_H
+#define WFC_PATTERNTABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "../utility/Hash.h"
+
+namespace WFC {
+
+    //deduplicates fixed size keys by their raw bytes, keys get ids in the order they are first inserted,
+    //lookups go through a flat open addressing table so no key is ever converted to a string
+    class PatternTable {
+    public:
+        static constexpr size_t npos = static_cast<size_t>(-1);
+
+        explicit PatternTable(size_t keySize = 0);
+
+        //returns id of the key and true if it was not in the table before
+        std::pair<size_t, bool> insert(const uint8_t *key);
+
+        std::pair<size_t, bool> insert(const uint8_t *key, uint64_t hash);
+
+        //id of the key or npos
+        [[nodiscard]] size_t find(const uint8_t *key) const;
+
+        //id of the first stored key with this hash for which equal(id) holds, lets callers compare
+        //against data that was never packed into a key
+        template<typename Equal>
+        [[nodiscard]] size_t find(uint64_t hash, Equal equal) const {
+            if (slots.empty()) {
+                return npos;
+            }
+            size_t mask = slots.size() - 1;
+            for (size_t slot = Util::Hash::mix(hash) & mask;; slot = (slot + 1) & mask) {
+                uint32_t entry = slots[slot];
+                if (entry == 0) {
+                    return npos;
+                }
+                if (hashes[entry - 1] == hash && equal(static_cast<size_t>(entry - 1))) {
+                    return entry - 1;
+                }
+            }
+        }
+
+        [[nodiscard]] size_t size() const;
+
+        [[nodiscard]] size_t getKeySize() const;
+
+        [[nodiscard]] const uint8_t *key(size_t id) const;
+
+        [[nodiscard]] uint64_t hashOf(size_t id) const;
+
+        //all keys back to back in id order
+        [[nodiscard]] const std::vector<uint8_t> &getKeys() const;
+
+        [[nodiscard]] uint64_t hashKey(const uint8_t *key) const;
+
+    private:
+        void placeId(size_t id);
+
+        void grow();
+
+    private:
+        size_t keySize;
+        std::vector<uint8_t> keys;
+        std::vector<uint64_t> hashes;
+        //id + 1 of the key stored in the slot, 0 is an empty slot, size is always a power of two
+        std::vector<uint32_t> slots;
+    };
+}
+
+#endif //WFC_PATTERNTABLE_H
@@ -0,0 +1,170 @@
+//
+// Created on 18.10.2026.
+//
+
+#include "RollingHash.h"
+
+#include <algorithm>
+
+#include "Palette.h"
+
+namespace {
+    //odd, so both have an inverse modulo 2^64
+    constexpr uint64_t baseX = 0x9E3779B97F4A7C15ULL;
+    constexpr uint64_t baseY = 0xC2B2AE3D27D4EB4FULL;
+
+    uint64_t power(uint64_t base, size_t exponent) {
+        uint64_t result = 1;
+        for (size_t i = 0; i < exponent; i++) {
+            result *= base;
+        }
+        return result;
+    }
+
+    uint64_t inverse(uint64_t odd) {
+        //newton iteration, every step doubles the number of correct low bits
+        uint64_t result = odd;
+        for (int i = 0; i < 5; i++) {
+            result *= 2 - odd * result;
+        }
+        return result;
+    }
+}
+
+WFC::RollingHash::RollingHash(const uint8_t *indices, size_t width, size_t height, size_t indexBytes,
+                              size_t patternSize, const std::vector<uint8_t> &transforms) :
+        indices(indices),
+        width(width),
+        indexBytes(indexBytes),
+        patternSize(patternSize),
+        windowsPerRow(width - patternSize + 1),
+        lastRow(height) {
+    //row sums go along x with one of these, x and y in the name are the axes of the transformed pattern
+    bases = {makeBase(baseX, patternSize), makeBase(inverse(baseX), patternSize),
+             makeBase(baseY, patternSize), makeBase(inverse(baseY), patternSize)};
+
+    //a transformed window has the hash of its pattern, sum_(x, y) v(source(x, y)) * baseX^x * baseY^y, written
+    //as a sum over source points, the source x gets the base of whichever pattern axis it ends up on
+    for (uint8_t transform: transforms) {
+        bool swap = transform & Transpose;
+        bool reverseRow = swap ? (transform & MirrorY) : (transform & MirrorX);
+        bool reverseColumn = swap ? (transform & MirrorX) : (transform & MirrorY);
+        uint64_t rowStep = swap ? baseY : baseX;
+        uint64_t columnStep = swap ? baseX : baseY;
+
+        //reversed exponent n - 1 - i is base^(n - 1) * inverse^i
+        Variant variant{};
+        variant.rowBase = (swap ? 2 : 0) + (reverseRow ? 1 : 0);
+        variant.columnBase = makeBase(reverseColumn ? inverse(columnStep) : columnStep, patternSize);
+        variant.factor = 1;
+        if (reverseRow) {
+            variant.factor *= power(rowStep, patternSize - 1);
+        }
+        if (reverseColumn) {
+            variant.factor *= power(columnStep, patternSize - 1);
+        }
+        variants.push_back(variant);
+    }
+
+    rowSums.resize(bases.size() * patternSize * windowsPerRow);
+    columnSums.resize(variants.size() * windowsPerRow);
+    windowHashes.resize(variants.size() * windowsPerRow);
+    nextRow.resize(windowsPerRow);
+}
+
+void WFC::RollingHash::hashRow(size_t y) {
+    size_t n = patternSize;
+    bool usedBases[4] = {false, false, false, false};
+    for (const auto &variant: variants) {
+        usedBases[variant.rowBase] = true;
+    }
+
+    if (y == lastRow + 1) {
+        //the row leaving the windows and the one entering them share the same slot
+        size_t slot = (y + n - 1) % n;
+        for (size_t base = 0; base < bases.size(); base++) {
+            if (!usedBases[base]) {
+                continue;
+            }
+            sumRow(y + n - 1, base, nextRow.data());
+            uint64_t *oldRow = rowSums.data() + (base * n + slot) * windowsPerRow;
+            for (size_t v = 0; v < variants.size(); v++) {
+                if (variants[v].rowBase != base) {
+                    continue;
+                }
+                const Base &column = variants[v].columnBase;
+                uint64_t *sums = columnSums.data() + v * windowsPerRow;
+                for (size_t x = 0; x < windowsPerRow; x++) {
+                    sums[x] = (sums[x] - oldRow[x]) * column.inverse + nextRow[x] * column.last;
+                }
+            }
+            std::copy(nextRow.begin(), nextRow.end(), oldRow);
+        }
+    } else {
+        for (size_t base = 0; base < bases.size(); base++) {
+            if (!usedBases[base]) {
+                continue;
+            }
+            for (size_t row = y; row < y + n; row++) {
+                sumRow(row, base, rowSums.data() + (base * n + row % n) * windowsPerRow);
+            }
+        }
+        for (size_t v = 0; v < variants.size(); v++) {
+            uint64_t *sums = columnSums.data() + v * windowsPerRow;
+            std::fill(sums, sums + windowsPerRow, 0);
+            uint64_t factor = 1;
+            for (size_t row = y; row < y + n; row++) {
+                const uint64_t *rowSum = rowSums.data() + (variants[v].rowBase * n + row % n) * windowsPerRow;
+                for (size_t x = 0; x < windowsPerRow; x++) {
+                    sums[x] += rowSum[x] * factor;
+                }
+                factor *= variants[v].columnBase.step;
+            }
+        }
+    }
+
+    for (size_t v = 0; v < variants.size(); v++) {
+        for (size_t x = 0; x < windowsPerRow; x++) {
+            windowHashes[v * windowsPerRow + x] = columnSums[v * windowsPerRow + x] * variants[v].factor;
+        }
+    }
+    lastRow = y;
+}
+
+uint64_t WFC::RollingHash::hashPattern(const uint8_t *pattern, size_t patternSize, size_t indexBytes) {
+    uint64_t hash = 0;
+    uint64_t rowFactor = 1;
+    for (size_t y = 0; y < patternSize; y++) {
+        uint64_t factor = rowFactor;
+        for (size_t x = 0; x < patternSize; x++) {
+            hash += (Palette::readIndex(pattern, y * patternSize + x, indexBytes) + 1) * factor;
+            factor *= baseX;
+        }
+        rowFactor *= baseY;
+    }
+    return hash;
+}
+
+void WFC::RollingHash::sumRow(size_t y, size_t base, uint64_t *sums) const {
+    const Base &powers = bases[base];
+    uint64_t sum = 0;
+    uint64_t factor = 1;
+    for (size_t x = 0; x < patternSize; x++) {
+        sum += value(x, y) * factor;
+        factor *= powers.step;
+    }
+    sums[0] = sum;
+    for (size_t x = 1; x < windowsPerRow; x++) {
+        sum = (sum - value(x - 1, y)) * powers.inverse + value(x + patternSize - 1, y) * powers.last;
+        sums[x] = sum;
+    }
+}
+
+uint64_t WFC::RollingHash::value(size_t x, size_t y) const {
+    //shifted by one so that index 0 still changes the hash
+    return Palette::readIndex(indices, y * width + x, indexBytes) + 1;
+}
+
+WFC::RollingHash::Base WFC::RollingHash::makeBase(uint64_t step, size_t patternSize) {
+    return {step, inverse(step), power(step, patternSize - 1)};
+}
@@ -0,0 +1,72 @@
+//
+// Created on 18.10.2026.
+//
+
+#ifndef WFC_ROLLINGHASH_H
+#define WFC_ROLLINGHASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Symmetry.h"
+
+namespace WFC {
+
+    //polynomial hashes of every n x n window of an index image and of its transformed variants,
+    //moving to the next window or the next row only updates the previous sums, so each hash costs O(1)
+    class RollingHash {
+    public:
+        RollingHash(const uint8_t *indices, size_t width, size_t height, size_t indexBytes, size_t patternSize,
+                    const std::vector<uint8_t> &transforms);
+
+        //hashes all windows with top row y, calling it for consecutive rows only updates the previous row
+        void hashRow(size_t y);
+
+        //hash of the window at x in the last hashed row seen through transforms[variant]
+        [[nodiscard]] uint64_t get(size_t variant, size_t x) const {
+            return windowHashes[variant * windowsPerRow + x];
+        }
+
+        //hash of a packed pattern, equal to the hash of any window that holds the same indices
+        static uint64_t hashPattern(const uint8_t *pattern, size_t patternSize, size_t indexBytes);
+
+    private:
+        //powers used by one kind of row sum
+        struct Base {
+            uint64_t step;
+            uint64_t inverse;
+            uint64_t last;
+        };
+
+        //how a variant is combined from row sums, reversed axes go through the inverse base
+        struct Variant {
+            size_t rowBase;
+            Base columnBase;
+            uint64_t factor;
+        };
+
+        void sumRow(size_t y, size_t base, uint64_t *sums) const;
+
+        [[nodiscard]] uint64_t value(size_t x, size_t y) const;
+
+        static Base makeBase(uint64_t step, size_t patternSize);
+
+    private:
+        const uint8_t *indices;
+        size_t width;
+        size_t indexBytes;
+        size_t patternSize;
+        size_t windowsPerRow;
+        std::vector<Base> bases;
+        std::vector<Variant> variants;
+        //sums of the rows under the current windows, rowSums[(base * n + row % n) * windowsPerRow + x]
+        std::vector<uint64_t> rowSums;
+        std::vector<uint64_t> columnSums;
+        std::vector<uint64_t> windowHashes;
+        std::vector<uint64_t> nextRow;
+        size_t lastRow;
+    };
+}
+
+#endif //WFC_ROLLINGHASH_H
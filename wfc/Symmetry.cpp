@@ -0,0 +1,92 @@
+//
+// Created on 18.10.2026.
+//
+
+#include "Symmetry.h"
+
+#include <cstring>
+
+namespace {
+    //result of applying first and then second, found by comparing where the corners of a 2x2 pattern end up
+    std::array<std::array<uint8_t, WFC::Symmetry::transformCount>, WFC::Symmetry::transformCount> buildCompositions() {
+        std::array<std::array<uint8_t, WFC::Symmetry::transformCount>, WFC::Symmetry::transformCount> table{};
+        for (uint8_t first = 0; first < WFC::Symmetry::transformCount; first++) {
+            for (uint8_t second = 0; second < WFC::Symmetry::transformCount; second++) {
+                for (uint8_t candidate = 0; candidate < WFC::Symmetry::transformCount; candidate++) {
+                    bool same = true;
+                    for (int corner = 0; corner < 4 && same; corner++) {
+                        Util::Point afterSecond = WFC::sourcePoint(second, corner % 2, corner / 2, 2);
+                        Util::Point composed = WFC::sourcePoint(first, afterSecond.x, afterSecond.y, 2);
+                        same = composed == WFC::sourcePoint(candidate, corner % 2, corner / 2, 2);
+                    }
+                    if (same) {
+                        table[first][second] = candidate;
+                        break;
+                    }
+                }
+            }
+        }
+        return table;
+    }
+
+    const auto compositions = buildCompositions();
+}
+
+WFC::Symmetry::Symmetry(size_t patternSize) :
+        patternSize(patternSize),
+        permutations(transformCount * patternSize * patternSize) {
+    int size = static_cast<int>(patternSize);
+    for (uint8_t transform = 0; transform < transformCount; transform++) {
+        uint16_t *table = permutations.data() + transform * patternSize * patternSize;
+        for (int y = 0; y < size; y++) {
+            for (int x = 0; x < size; x++) {
+                Util::Point source = sourcePoint(transform, x, y, size);
+                table[y * size + x] = static_cast<uint16_t>(source.y * size + source.x);
+            }
+        }
+    }
+}
+
+const uint16_t *WFC::Symmetry::permutation(uint8_t transform) const {
+    return permutations.data() + transform * patternSize * patternSize;
+}
+
+void WFC::Symmetry::apply(uint8_t transform, const uint8_t *pattern, uint8_t *result, size_t indexBytes) const {
+    const uint16_t *table = permutation(transform);
+    size_t elements = patternSize * patternSize;
+    if (indexBytes == 1) {
+        for (size_t element = 0; element < elements; element++) {
+            result[element] = pattern[table[element]];
+        }
+        return;
+    }
+    for (size_t element = 0; element < elements; element++) {
+        std::memcpy(result + element * indexBytes, pattern + table[element] * indexBytes, indexBytes);
+    }
+}
+
+uint8_t WFC::Symmetry::compose(uint8_t first, uint8_t second) {
+    return compositions[first][second];
+}
+
+uint8_t WFC::Symmetry::inverse(uint8_t transform) {
+    for (uint8_t candidate = 0; candidate < transformCount; candidate++) {
+        if (compose(transform, candidate) == Identity) {
+            return candidate;
+        }
+    }
+    return Identity;
+}
+
+std::vector<uint8_t> WFC::Symmetry::group(bool rotate, bool flip) {
+    if (rotate && flip) {
+        return {Identity, MirrorX, MirrorY, Rotate180, Transpose, Rotate90, Rotate270, AntiTranspose};
+    }
+    if (rotate) {
+        return {Identity, Rotate90, Rotate180, Rotate270};
+    }
+    if (flip) {
+        return {Identity, MirrorX, MirrorY, Rotate180};
+    }
+    return {Identity};
+}
@@ -0,0 +1,67 @@
+//
+// Created on 18.10.2026.
+//
+
+#ifndef WFC_SYMMETRY_H
+#define WFC_SYMMETRY_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "../utility/Point.h"
+
+namespace WFC {
+
+    //rotations and mirrors of a square pattern, bit 0 mirrors x, bit 1 mirrors y and bit 2 swaps x and y
+    //after mirroring, every combination of the three bits is one of the 8 symmetries of a square
+    enum Transform : uint8_t {
+        Identity = 0,
+        MirrorX = 1,
+        MirrorY = 2,
+        Rotate180 = 3,
+        Transpose = 4,
+        Rotate90 = 5,
+        Rotate270 = 6,
+        AntiTranspose = 7
+    };
+
+    //point of the source pattern that ends up at x, y of the transformed one, rotations are clockwise
+    inline Util::Point sourcePoint(uint8_t transform, int x, int y, int size) {
+        int mirroredX = (transform & MirrorX) ? size - 1 - x : x;
+        int mirroredY = (transform & MirrorY) ? size - 1 - y : y;
+        if (transform & Transpose) {
+            return {mirroredY, mirroredX};
+        }
+        return {mirroredX, mirroredY};
+    }
+
+    //dihedral group of a square applied to patterns of one size through precomputed index permutations
+    class Symmetry {
+    public:
+        static constexpr size_t transformCount = 8;
+
+        explicit Symmetry(size_t patternSize = 1);
+
+        //element of the source pattern that ends up at each element of the transformed one, row by row
+        [[nodiscard]] const uint16_t *permutation(uint8_t transform) const;
+
+        void apply(uint8_t transform, const uint8_t *pattern, uint8_t *result, size_t indexBytes) const;
+
+        //transform that has the same effect as applying first and then second
+        static uint8_t compose(uint8_t first, uint8_t second);
+
+        static uint8_t inverse(uint8_t transform);
+
+        //transforms generated by the enabled options, rotations give the 4 rotations, flips give both mirrors
+        //and their product, both together give all 8
+        static std::vector<uint8_t> group(bool rotate, bool flip);
+
+    private:
+        size_t patternSize;
+        std::vector<uint16_t> permutations;
+    };
+}
+
+#endif //WFC_SYMMETRY_H
@@ -9,7 +9,6 @@ WFC::WFC::WFC(const std::string_view &pathToInputImage, AnalyzerOptions &options
          size_t width, size_t height) :
         analyzer(options, pathToInputImage),
         backtracker(backtrackerOptions),
-        rng(std::random_device{}()),
         savePaths({
                           "../outputs/patterns/generated-patterns.png",
                           "../outputs/solution.png",
@@ -17,7 +16,9 @@ WFC::WFC::WFC(const std::string_view &pathToInputImage, AnalyzerOptions &options
                           "../outputs/iterations/",
                           true
                   }),
-        status(WFCStatus::PREPARING) {
+        status(WFCStatus::PREPARING),
+        solverOptions({1, 1, 0, false, Util::Random::randomSeed()}) {
+    rng = Util::Random::makeGenerator(solverOptions.seed);
     outWidth = width;
     outHeight = height;
     state.iteration = 0;
@@ -40,17 +41,23 @@ void WFC::WFC::setBacktrackerOptions(const BacktrackerOptions &options) {
     backtracker.setOptions(options);
 }
 
+void WFC::WFC::setSolverOptions(const SolverOptions &options) {
+    solverOptions = options;
+    rng = Util::Random::makeGenerator(solverOptions.seed);
+}
+
 void WFC::WFC::prepareWFC() {
     analyzer.analyze();
     createDirectories();
     //initialize coeff matrix to be outputSize x outputSize x unique patterns count
+    state.state = Wave(outWidth, outHeight, analyzer.getPatternCount());
     logState();
-    state.state = std::vector<std::vector<std::vector<bool>>>(
-            outHeight, std::vector<std::vector<bool>>(
-                    outWidth, std::vector<bool>(
-                            analyzer.getPatterns().size(), true)
-            ));
-    logState();
+    threadPool = std::make_unique<Util::ThreadPool>(std::max<size_t>(1, solverOptions.threads));
+    supportMasks.assign(threadPool->getThreadCount(), std::vector<uint64_t>(state.state.getWordsPerCell()));
+    queuedCells = std::vector<std::atomic<bool>>(state.state.getCellCount());
+    nextFrontier.resize(state.state.getCellCount());
+    frontierWords.resize(state.state.getCellCount() * state.state.getWordsPerCell());
+    lastComponentSearch = state.state.getCellCount();
     //initialize collapsed tiles to be outputSize x outputSize with invalid value
     state.collapsed = std::vector<std::vector<int>>(outHeight, std::vector<int>(outWidth, -1));
     if (savePaths.savePatterns) {
@@ -64,12 +71,13 @@ void WFC::WFC::setSavePaths(const WFCSavePaths &paths) {
 
 bool WFC::WFC::startWFC() {
     Util::Timer timer("startWFC");
+    Util::Logger::log(Util::LogLevel::Important, "Seed: " + std::to_string(solverOptions.seed));
     status = WFCStatus::RUNNING;
     size_t globalIterations = 0;
     while (status == WFCStatus::RUNNING) {
         Util::Logger::log(Util::LogLevel::Debug, "Iteration: " + std::to_string(state.iteration));
 
-        auto lowestEntropy = Observe();
+        auto collapsedPoints = Observe();
 
         if (status == WFCStatus::CONTRADICTION) {
             Util::Logger::log(Util::LogLevel::Important, "Contradiction found");
@@ -89,9 +97,19 @@ bool WFC::WFC::startWFC() {
         }
 
         //if backtracking on, skip propagation
-        if (lowestEntropy != Util::Point(-1, -1)) {
-            propagate(lowestEntropy);
+        if (!collapsedPoints.empty()) {
+            bool consistent = propagate(collapsedPoints);
+            if (!consistent && collapsedPoints.size() > 1) {
+                consistent = rollbackBatch(collapsedPoints.front());
+            }
             state.iteration++;
+
+            if (consistent && solverOptions.components) {
+                auto components = findComponents();
+                if (components.size() > 1) {
+                    solveComponents(components);
+                }
+            }
         }
 
         if (savePaths.savePatterns) {
@@ -108,8 +126,42 @@ bool WFC::WFC::startWFC() {
     return status == WFCStatus::SOLUTION;
 }
 
-Util::Point WFC::WFC::Observe() {
-    static std::chrono::duration<double> observeTime;
+bool WFC::WFC::startBatch(const BatchOptions &options) {
+    Util::Timer timer("startBatch");
+    Util::Logger::log(Util::LogLevel::Important, "Seed: " + std::to_string(solverOptions.seed));
+    BatchSolver solver(analyzer, outWidth, outHeight);
+    //seed of a job depends only on its index, not on the lane or thread that ends up solving it
+    uint64_t batchSeed = Util::Random::splitSeed(solverOptions.seed, static_cast<uint64_t>(SeedStream::Batch));
+    std::vector<uint64_t> jobSeeds(options.count);
+    for (size_t job = 0; job < options.count; job++) {
+        jobSeeds[job] = Util::Random::splitSeed(batchSeed, job);
+    }
+
+    //every thread runs its own set of lanes, all of them take jobs from the same counter
+    std::vector<cimg::CImg<unsigned char>> outputs(options.count);
+    std::atomic<size_t> nextJob{0};
+    threadPool->parallelFor(threadPool->getThreadCount(), [&](size_t begin, size_t end, size_t) {
+        for (size_t i = begin; i < end; i++) {
+            solver.solve(nextJob, jobSeeds, options.attempts, outputs);
+        }
+    });
+
+    size_t solved = 0;
+    for (size_t job = 0; job < outputs.size(); job++) {
+        if (outputs[job].is_empty()) {
+            continue;
+        }
+        std::string filePath = savePaths.outputImageDir + "batch_" + std::to_string(job) + ".png";
+        outputs[job].save_png(Util::FileUtil::getUniqueFileName(filePath).c_str());
+        solved++;
+    }
+    Util::Logger::log(Util::LogLevel::Important,
+                      "Batch solved " + std::to_string(solved) + " of " + std::to_string(options.count) + " outputs");
+    status = solved == options.count ? WFCStatus::SOLUTION : WFCStatus::CONTRADICTION;
+    return status == WFCStatus::SOLUTION;
+}
+
+std::vector<Util::Point> WFC::WFC::Observe() {
     Util::Timer timer("Observe function");
 
     Util::Logger::log(Util::LogLevel::Debug, "backtrack check");
@@ -148,18 +200,35 @@ Util::Point WFC::WFC::Observe() {
             status = WFCStatus::CONTRADICTION;
         }
         Util::Logger::log(Util::LogLevel::Debug, "was found, returning min point");
-        return minEntropyPoint;
-    } else {
-        Util::Logger::log(Util::LogLevel::Debug, "finding min entropy point");
-        std::vector<double> minEntropyProbabilities;
-        std::tie(minEntropyPoint, minEntropyProbabilities) = findMinEntropyPoint(entropyMatrix);
-        if (status == WFCStatus::SOLUTION) {
-            return minEntropyPoint;
-        }
-        Util::Logger::log(Util::LogLevel::Debug, "found, starting to collapse");
-        collapseCell(minEntropyPoint, minEntropyProbabilities);
+        return {};
     }
-    return minEntropyPoint;
+
+    Util::Logger::log(Util::LogLevel::Debug, "finding min entropy point");
+    std::vector<double> minEntropyProbabilities;
+    std::tie(minEntropyPoint, minEntropyProbabilities) = findMinEntropyPoint(entropyMatrix);
+    if (status == WFCStatus::SOLUTION) {
+        return {};
+    }
+
+    std::vector<Util::Point> collapsedPoints{minEntropyPoint};
+    if (solverOptions.collapseBatch > 1) {
+        std::vector<Util::Point> distantPoints = findDistantPoints(entropyMatrix, minEntropyPoint);
+        collapsedPoints.insert(collapsedPoints.end(), distantPoints.begin(), distantPoints.end());
+    }
+
+    rememberState();
+    //keep the state before the batch so that a conflict between its cells can be undone
+    if (collapsedPoints.size() > 1) {
+        batchSnapshot = state;
+    }
+
+    Util::Logger::log(Util::LogLevel::Debug, "found, starting to collapse");
+    collapseCell(minEntropyPoint, minEntropyProbabilities);
+    for (size_t i = 1; i < collapsedPoints.size(); i++) {
+        std::vector<double> probabilities = getPossibleProbabilities(collapsedPoints[i]);
+        collapseCell(collapsedPoints[i], probabilities);
+    }
+    return collapsedPoints;
 }
 
 void WFC::WFC::createDirectories() {
@@ -196,7 +265,7 @@ bool WFC::WFC::checkForContradiction() const {
     //if any cell has no possible patterns then there is a contradiction
     for (size_t i = 0; i < outHeight; i++) {
         for (size_t j = 0; j < outWidth; j++) {
-            if (std::count(state.state[i][j].begin(), state.state[i][j].end(), true) == 0) {
+            if (state.state.count(i * outWidth + j) == 0) {
                 return false;
             }
         }
@@ -207,14 +276,11 @@ bool WFC::WFC::checkForContradiction() const {
 double WFC::WFC::getShannonEntropy(const Util::Point &p) const {
     double sumWeights = 0;
     double sumLogWeights = 0;
-    for (size_t option = 0; option < state.state.at(p.y).at(p.x).size(); option++) {
-        if (state.state.at(p.y).at(p.x).at(option)) {
-            double weight = analyzer.getProbabilities().at(option);
-            sumWeights += weight;
-            sumLogWeights += weight * std::log(weight);
-        }
-
-    }
+    state.state.forEachPattern(state.state.cellIndex(p), [&](size_t option) {
+        double weight = analyzer.getProbabilities()[option];
+        sumWeights += weight;
+        sumLogWeights += weight * std::log(weight);
+    });
     if (sumWeights == 0) {
         return 0;
     }
@@ -265,18 +331,61 @@ WFC::WFC::findMinEntropyPoint(std::vector<std::vector<double>> &entropyMatrix) {
     }
 
     //get possible probabilities for that point
-    std::vector<double> minEntropyProbabilities(state.state[minPoint.y][minPoint.x].size());
-    for (size_t k = 0; k < state.state[minPoint.y][minPoint.x].size(); k++) {
-        //if that pattern is possible, get its probability, else set it to 0
-        minEntropyProbabilities[k] = state.state[minPoint.y][minPoint.x][k] ? analyzer.getProbabilities()[k] : 0.0;
-    }
+    return {minPoint, getPossibleProbabilities(minPoint)};
+}
 
-    return {minPoint, minEntropyProbabilities};
+std::vector<double> WFC::WFC::getPossibleProbabilities(const Util::Point &p) const {
+    //if that pattern is possible, get its probability, else leave it at 0
+    std::vector<double> probabilities(state.state.getPatternCount(), 0.0);
+    state.state.forEachPattern(state.state.cellIndex(p), [&](size_t k) {
+        probabilities[k] = analyzer.getProbabilities()[k];
+    });
+    return probabilities;
 }
 
-void WFC::WFC::collapseCell(const Util::Point &p, std::vector<double> &probabilities) {
-    static std::chrono::duration<double> collapseTime;
+std::vector<Util::Point>
+WFC::WFC::findDistantPoints(const std::vector<std::vector<double>> &entropyMatrix, const Util::Point &first) {
+    //all not collapsed cells, shuffled first so that cells with equal entropy are picked randomly
+    std::vector<std::pair<double, Util::Point>> candidates;
+    for (int i = 0; i < entropyMatrix.size(); i++) {
+        for (int j = 0; j < entropyMatrix[i].size(); j++) {
+            if (state.collapsed[i][j] == -1 && entropyMatrix[i][j] > 0 && Util::Point(j, i) != first) {
+                candidates.emplace_back(entropyMatrix[i][j], Util::Point(j, i));
+            }
+        }
+    }
+    std::shuffle(candidates.begin(), candidates.end(), rng);
+    std::stable_sort(candidates.begin(), candidates.end(), [](const auto &a, const auto &b) {
+        return a.first < b.first;
+    });
+
+    //greedily take the lowest entropy cells that are far enough from every cell picked so far
+    std::vector<Util::Point> picked{first};
+    for (const auto &candidate: candidates) {
+        if (picked.size() >= solverOptions.collapseBatch) {
+            break;
+        }
+        bool isDistant = std::all_of(picked.begin(), picked.end(), [&](const Util::Point &p) {
+            return wrappedDistance(p, candidate.second) > solverOptions.collapseRadius;
+        });
+        if (isDistant) {
+            picked.push_back(candidate.second);
+        }
+    }
+    picked.erase(picked.begin());
+    return picked;
+}
+
+int WFC::WFC::wrappedDistance(const Util::Point &a, const Util::Point &b) const {
+    //chebyshev distance on the torus, the output wraps around in both directions
+    int dx = std::abs(a.x - b.x);
+    int dy = std::abs(a.y - b.y);
+    dx = std::min(dx, static_cast<int>(outWidth) - dx);
+    dy = std::min(dy, static_cast<int>(outHeight) - dy);
+    return std::max(dx, dy);
+}
 
+void WFC::WFC::rememberState() {
     //if is backtracking enabled and is currently not in backtracking, remember the state
     if (backtracker.isEnabled()) {
         if (backtracker.isBacktracking()) {
@@ -285,91 +394,340 @@ void WFC::WFC::collapseCell(const Util::Point &p, std::vector<double> &probabili
             backtracker.push(state);
         }
     }
+}
 
+bool WFC::WFC::rollbackBatch(const Util::Point &first) {
+    //cells of the batch conflicted with each other, undo the batch and collapse only its lowest entropy cell
+    Util::Logger::log(Util::LogLevel::Debug, "Collapse batch conflicted, rolling back to a single cell");
+    state = batchSnapshot;
+    std::vector<double> probabilities = getPossibleProbabilities(first);
+    collapseCell(first, probabilities);
+    return propagate({first});
+}
+
+void WFC::WFC::collapseCell(const Util::Point &p, std::vector<double> &probabilities) {
     //choose a random possible option from probabilities vector and mark that chosen index in collapsedTiles
     std::discrete_distribution<size_t> dist(probabilities.begin(), probabilities.end());
     size_t chosenPattern = dist(rng);
     state.collapsed[p.y][p.x] = static_cast<int>(chosenPattern);
-
-    for (size_t i = 0; i < state.state[p.y][p.x].size(); i++) {
-        state.state[p.y][p.x][i] = (i == chosenPattern);
-    }
+    state.state.collapse(state.state.cellIndex(p), chosenPattern);
 }
 
-void WFC::WFC::propagate(Util::Point &minEntropyPoint) {
-    static std::chrono::duration<double> propagationTime;
+bool WFC::WFC::propagate(const std::vector<Util::Point> &collapsedPoints) {
     Util::Timer timer("propagate function");
-    std::deque<Util::Point> propagationQueue;
-    std::set<Util::Point> visited;
-    propagationQueue.push_back(minEntropyPoint);
-    visited.insert(minEntropyPoint);
-    while (!propagationQueue.empty()) {
-        Util::Point currentPoint = propagationQueue.front();
-        propagationQueue.pop_front();
-        for (const auto &offset: analyzer.getOffsets()) {
-            //get neighbor pos from current pos and offset
-            Util::Point neighborPoint = wrapPoint(currentPoint, offset);
-
-            //if neighbor is not valid or is collapsed already, skip it
-            if (!isPointValid(neighborPoint) || state.collapsed[neighborPoint.y][neighborPoint.x] != -1) {
-                continue;
+    //cells per chunk handed to a thread, small frontiers are processed on the calling thread
+    constexpr size_t frontierChunk = 4;
+    size_t wordsPerCell = state.state.getWordsPerCell();
+    bool atomic = threadPool->getThreadCount() > 1;
+    std::vector<size_t> frontier;
+    for (const auto &p: collapsedPoints) {
+        frontier.push_back(state.state.cellIndex(p));
+    }
+    std::atomic<size_t> nextSize{0};
+
+    //every round processes the whole frontier, changed neighbours form the next frontier. a round reads its cells
+    //from a copy taken before it and and-s the supports into their neighbours, which does not depend on the order,
+    //so the state after each round, including the one that ends in a contradiction, is the same for any number of
+    //threads
+    while (!frontier.empty()) {
+        for (size_t i = 0; i < frontier.size(); i++) {
+            queuedCells[frontier[i]].store(false, std::memory_order_relaxed);
+            for (size_t word = 0; word < wordsPerCell; word++) {
+                frontierWords[i * wordsPerCell + word] = state.state.getWord(frontier[i], word);
+            }
+        }
+        nextSize.store(0, std::memory_order_relaxed);
+
+        threadPool->parallelFor(frontier.size(), [&](size_t begin, size_t end, size_t worker) {
+            std::vector<uint64_t> &mask = supportMasks[worker];
+            for (size_t i = begin; i < end; i++) {
+                Util::Point currentPoint = state.state.cellPoint(frontier[i]);
+                for (const auto &offset: analyzer.getOffsets()) {
+                    size_t neighborCell = state.state.cellIndex(wrapPoint(currentPoint, offset));
+                    collectSupport(frontierWords.data() + i * wordsPerCell, offset, mask);
+                    bool changed = atomic ? state.state.intersectAtomic(neighborCell, mask.data())
+                                          : state.state.intersect(neighborCell, mask.data());
+                    //only the thread that flips the flag appends the cell, so it is queued once per round
+                    if (changed && !queuedCells[neighborCell].exchange(true, std::memory_order_relaxed)) {
+                        nextFrontier[nextSize.fetch_add(1, std::memory_order_relaxed)] = neighborCell;
+                    }
+                }
             }
+        }, frontierChunk);
 
-            //update neighbor cell
-            bool updated, collapsed;
-            std::tie(updated, collapsed) = updateCell(currentPoint, neighborPoint, offset);
+        frontier.assign(nextFrontier.begin(), nextFrontier.begin() + static_cast<long>(nextSize.load()));
+        bool contradiction = false;
+        for (size_t cell: frontier) {
+            if (!refreshCollapsed(cell)) {
+                contradiction = true;
+            }
+        }
+        //no pattern left, stop propagating and let observe handle the contradiction
+        if (contradiction) {
+            for (size_t cell: frontier) {
+                queuedCells[cell].store(false, std::memory_order_relaxed);
+            }
+            return false;
+        }
+    }
+    return true;
+}
 
-            //if updated, add to propagation queue and not in queue already
-            if (updated) {
-                if (visited.find(neighborPoint) == visited.end()) {
-                    propagationQueue.push_back(neighborPoint);
-                    visited.insert(neighborPoint);
+std::vector<std::vector<size_t>> WFC::WFC::findComponents() {
+    //collapsed cells split the rest only after enough of them were added since the last search, so searches start once
+    //half of the cells are collapsed and then run after every eighth of the remaining cells is collapsed
+    constexpr size_t searchFraction = 8;
+    size_t notCollapsed = 0;
+    for (const auto &row: state.collapsed) {
+        notCollapsed += std::count(row.begin(), row.end(), -1);
+    }
+    if (notCollapsed * 2 > state.state.getCellCount()) {
+        return {};
+    }
+    //backtracking brings cells back, the islands found before are no longer valid then
+    bool backtracked = notCollapsed > lastComponentSearch;
+    size_t searchStep = std::max<size_t>(1, lastComponentSearch / searchFraction);
+    if (!backtracked && lastComponentSearch - notCollapsed < searchStep) {
+        return {};
+    }
+    lastComponentSearch = notCollapsed;
+
+    //two not collapsed cells are connected if one is within the offsets of the other, collapsed cells only
+    //separate them because their single pattern already restricted all their neighbours
+    cellComponents.assign(state.state.getCellCount(), -1);
+    std::vector<std::vector<size_t>> components;
+    for (size_t cell = 0; cell < state.state.getCellCount(); cell++) {
+        Util::Point p = state.state.cellPoint(cell);
+        if (state.collapsed[p.y][p.x] != -1 || cellComponents[cell] != -1) {
+            continue;
+        }
+        int component = static_cast<int>(components.size());
+        components.emplace_back();
+        std::vector<size_t> &cells = components.back();
+        cells.push_back(cell);
+        cellComponents[cell] = component;
+        for (size_t i = 0; i < cells.size(); i++) {
+            Util::Point currentPoint = state.state.cellPoint(cells[i]);
+            for (const auto &offset: analyzer.getOffsets()) {
+                Util::Point neighborPoint = wrapPoint(currentPoint, offset);
+                size_t neighborCell = state.state.cellIndex(neighborPoint);
+                if (state.collapsed[neighborPoint.y][neighborPoint.x] == -1 && cellComponents[neighborCell] == -1) {
+                    cellComponents[neighborCell] = component;
+                    cells.push_back(neighborCell);
                 }
             }
         }
     }
+    return components;
 }
 
-std::pair<bool, bool>
-WFC::WFC::updateCell(const Util::Point &current, const Util::Point &neighbour, const Util::Point &offset) {
-    //patterns for current and neighbour cell
-    std::vector<bool> &currentPatterns = state.state[current.y][current.x];
-    std::vector<bool> &neighbourPatterns = state.state[neighbour.y][neighbour.x];
+void WFC::WFC::solveComponents(const std::vector<std::vector<size_t>> &components) {
+    Util::Timer timer("solveComponents");
+    Util::Logger::log(Util::LogLevel::Info, "Solving " + std::to_string(components.size()) + " components separately");
+
+    //every component gets its own stream by index, so the result does not depend on which thread solves which
+    uint64_t componentsSeed = Util::Random::splitSeed(
+            Util::Random::splitSeed(solverOptions.seed, static_cast<uint64_t>(SeedStream::Components)),
+            state.iteration);
+    std::vector<size_t> iterations(components.size(), 0);
+    std::vector<char> solved(components.size(), false);
+
+    threadPool->parallelFor(components.size(), [&](size_t begin, size_t end, size_t worker) {
+        for (size_t i = begin; i < end; i++) {
+            solved[i] = solveComponent(static_cast<int>(i), components[i], Util::Random::splitSeed(componentsSeed, i),
+                                       supportMasks[worker], iterations[i]);
+        }
+    });
+
+    state.iteration += std::accumulate(iterations.begin(), iterations.end(), size_t{0});
+    size_t failed = std::count(solved.begin(), solved.end(), false);
+    if (failed > 0) {
+        //solved components keep their cells, failed ones are back where they started and the main loop continues
+        //collapsing them
+        Util::Logger::log(Util::LogLevel::Info, std::to_string(failed) + " components could not be solved");
+    }
+}
 
-    std::vector<bool> possiblePatternsInOffset(neighbourPatterns.size(), false);
-    for (size_t i = 0; i < currentPatterns.size(); i++) {
-        if (!currentPatterns[i]) {
-            continue;
+bool WFC::WFC::solveComponent(int component, const std::vector<size_t> &cells, uint64_t componentSeed,
+                              std::vector<uint64_t> &mask, size_t &iterations) {
+    //a component that runs out of history starts over from its own cells with the next seed of its stream
+    constexpr size_t attempts = 4;
+    ComponentSnapshot start = saveComponent(cells, 0);
+    for (size_t attempt = 0; attempt < attempts; attempt++) {
+        if (attempt > 0) {
+            restoreComponent(cells, start);
         }
-        const auto &rules = analyzer.getRules().at(i);
-        for (const auto &possiblePattern: rules.at(offset)) {
-            possiblePatternsInOffset[possiblePattern] = true;
+        uint64_t seed = attempt == 0 ? componentSeed : Util::Random::splitSeed(componentSeed, attempt);
+        std::mt19937 componentRng = Util::Random::makeGenerator(seed);
+        if (searchComponent(component, cells, componentRng, mask, iterations)) {
+            return true;
         }
     }
+    restoreComponent(cells, start);
+    return false;
+}
+
+bool WFC::WFC::searchComponent(int component, const std::vector<size_t> &cells, std::mt19937 &componentRng,
+                               std::vector<uint64_t> &mask, size_t &iterations) {
+    //same rules as the backtracker, but snapshots only hold the cells of this component
+    const BacktrackerOptions &backtrackerOptions = backtracker.getOptions();
+    std::deque<std::pair<ComponentSnapshot, size_t>> history;
+    size_t collapses = 0;
+    //after going back no snapshots are taken until the collapse that failed is passed, as the backtracker does while
+    //backtracking, otherwise every failure saves the state it went back to again and the history never runs out
+    size_t backtrackUntil = 0;
+    while (true) {
+        //find the lowest entropy cells of the component
+        double minEntropy = std::numeric_limits<double>::max();
+        std::vector<size_t> minEntropyCells;
+        for (size_t cell: cells) {
+            Util::Point p = state.state.cellPoint(cell);
+            if (state.collapsed[p.y][p.x] != -1) {
+                continue;
+            }
+            double entropy = getShannonEntropy(p);
+            if (entropy < minEntropy) {
+                minEntropy = entropy;
+                minEntropyCells.clear();
+            }
+            if (entropy == minEntropy) {
+                minEntropyCells.push_back(cell);
+            }
+        }
+        if (minEntropyCells.empty()) {
+            return true;
+        }
+
+        if (backtrackerOptions.enabled && collapses >= backtrackUntil) {
+            history.emplace_front(saveComponent(cells, collapses), backtrackerOptions.maxIterations);
+            if (history.size() > backtrackerOptions.maxDepth) {
+                history.pop_back();
+            }
+        }
 
-    //multiply the target cell by possible patterns form original cell
-    std::vector<bool> updatedCell(state.state[current.y][current.x].size());
-    for (size_t i = 0; i < updatedCell.size(); i++) {
-        updatedCell[i] = possiblePatternsInOffset[i] && neighbourPatterns[i];
+        std::uniform_int_distribution<size_t> cellDist(0, minEntropyCells.size() - 1);
+        size_t cell = minEntropyCells[cellDist(componentRng)];
+        Util::Point p = state.state.cellPoint(cell);
+        std::vector<double> probabilities = getPossibleProbabilities(p);
+        std::discrete_distribution<size_t> patternDist(probabilities.begin(), probabilities.end());
+        size_t chosenPattern = patternDist(componentRng);
+        state.collapsed[p.y][p.x] = static_cast<int>(chosenPattern);
+        state.state.collapse(cell, chosenPattern);
+        iterations++;
+        collapses++;
+
+        if (propagateComponent(cell, component, mask)) {
+            continue;
+        }
+        backtrackUntil = std::max(backtrackUntil, collapses);
+
+        //go back in the history of this component only, other components keep their progress
+        bool restored = false;
+        while (!history.empty()) {
+            if (history.front().second > 0) {
+                history.front().second--;
+                restoreComponent(cells, history.front().first);
+                collapses = history.front().first.collapses;
+                restored = true;
+                break;
+            }
+            history.pop_front();
+        }
+        if (!restored) {
+            return false;
+        }
     }
+}
 
-    //check if the cell was updated
-    bool isUpdated = (updatedCell != state.state[neighbour.y][neighbour.x]);
-    bool isCollapsed = std::count(updatedCell.begin(), updatedCell.end(), true) == 1;
+bool WFC::WFC::propagateComponent(size_t startCell, int component, std::vector<uint64_t> &mask) {
+    //only cells of the component are updated, so components can be propagated from different threads at once
+    std::deque<size_t> propagationQueue{startCell};
+    queuedCells[startCell] = true;
+    while (!propagationQueue.empty()) {
+        size_t currentCell = propagationQueue.front();
+        propagationQueue.pop_front();
+        queuedCells[currentCell] = false;
+        Util::Point currentPoint = state.state.cellPoint(currentCell);
+        for (const auto &offset: analyzer.getOffsets()) {
+            size_t neighborCell = state.state.cellIndex(wrapPoint(currentPoint, offset));
+            if (cellComponents[neighborCell] != component ||
+                !updateCell(currentCell, neighborCell, offset, mask)) {
+                continue;
+            }
+            if (!refreshCollapsed(neighborCell)) {
+                for (size_t cell: propagationQueue) {
+                    queuedCells[cell] = false;
+                }
+                return false;
+            }
+            if (!queuedCells[neighborCell]) {
+                propagationQueue.push_back(neighborCell);
+                queuedCells[neighborCell] = true;
+            }
+        }
+    }
+    return true;
+}
 
-    //set the cell as collapsed
-    if (isCollapsed) {
-        //find the index of the collapsed pattern
-        size_t collapsedPatternIndex = std::find(updatedCell.begin(), updatedCell.end(), true) - updatedCell.begin();
+WFC::ComponentSnapshot WFC::WFC::saveComponent(const std::vector<size_t> &cells, size_t collapses) const {
+    ComponentSnapshot snapshot;
+    snapshot.collapses = collapses;
+    size_t wordsPerCell = state.state.getWordsPerCell();
+    snapshot.words.reserve(cells.size() * wordsPerCell);
+    snapshot.collapsed.reserve(cells.size());
+    for (size_t cell: cells) {
+        for (size_t word = 0; word < wordsPerCell; word++) {
+            snapshot.words.push_back(state.state.getWord(cell, word));
+        }
+        Util::Point p = state.state.cellPoint(cell);
+        snapshot.collapsed.push_back(state.collapsed[p.y][p.x]);
+    }
+    return snapshot;
+}
 
-        //set the collapsed pattern in the collapsed tiles matrix
-        state.collapsed[neighbour.y][neighbour.x] = static_cast<int>(collapsedPatternIndex);
+void WFC::WFC::restoreComponent(const std::vector<size_t> &cells, const ComponentSnapshot &snapshot) {
+    size_t wordsPerCell = state.state.getWordsPerCell();
+    for (size_t i = 0; i < cells.size(); i++) {
+        state.state.setCell(cells[i], snapshot.words.data() + i * wordsPerCell);
+        Util::Point p = state.state.cellPoint(cells[i]);
+        state.collapsed[p.y][p.x] = snapshot.collapsed[i];
     }
+}
 
-    //update the cell in the coefficient matrix
-    state.state[neighbour.y][neighbour.x] = updatedCell;
+bool WFC::WFC::updateCell(size_t current, size_t neighbour, const Util::Point &offset, std::vector<uint64_t> &mask) {
+    //collect every pattern allowed at offset by any of the patterns still possible in current cell
+    std::fill(mask.begin(), mask.end(), 0);
+    state.state.forEachPattern(current, [&](size_t pattern) {
+        for (const auto &possiblePattern: analyzer.getRules()[pattern].at(offset)) {
+            mask[possiblePattern / 64] |= uint64_t{1} << (possiblePattern % 64);
+        }
+    });
 
-    return {isUpdated, isCollapsed};
+    //multiply the target cell by possible patterns from original cell
+    return state.state.intersect(neighbour, mask.data());
+}
+
+void WFC::WFC::collectSupport(const uint64_t *bits, const Util::Point &offset, std::vector<uint64_t> &mask) const {
+    std::fill(mask.begin(), mask.end(), 0);
+    for (size_t word = 0; word < mask.size(); word++) {
+        uint64_t patterns = bits[word];
+        while (patterns) {
+            size_t pattern = word * 64 + static_cast<size_t>(__builtin_ctzll(patterns));
+            for (const auto &possiblePattern: analyzer.getRules()[pattern].at(offset)) {
+                mask[possiblePattern / 64] |= uint64_t{1} << (possiblePattern % 64);
+            }
+            patterns &= patterns - 1;
+        }
+    }
+}
+
+bool WFC::WFC::refreshCollapsed(size_t cell) {
+    size_t possiblePatterns = state.state.count(cell);
+    if (possiblePatterns == 1) {
+        Util::Point p = state.state.cellPoint(cell);
+        state.collapsed[p.y][p.x] = static_cast<int>(state.state.firstPattern(cell));
+    }
+    return possiblePatterns > 0;
 }
 
 Util::Point WFC::WFC::wrapPoint(const Util::Point &p, const Util::Point &offset) const {
@@ -389,32 +747,7 @@ void WFC::WFC::displayOutputImage(const std::string &dir, const std::string &fil
         return;
     }
 
-    //i had the height and weight switched for god knows how long and god damn it took me so long to fix this
-    cimg_library::CImg<unsigned char> res(outWidth, outHeight, 1, 3, 0);
-    for (int y = 0; y < outHeight; y++) {
-        for (int x = 0; x < outWidth; x++) {
-            std::vector<cimg_library::CImg<unsigned char>> validPatterns;
-            for (int pattern = 0; pattern < analyzer.getPatterns().size(); pattern++) {
-                if (state.state.at(y).at(x).at(pattern)) {
-                    validPatterns.emplace_back(analyzer.getPatterns().at(pattern));
-                }
-            }
-            if (!validPatterns.empty()) {
-                cimg_library::CImg<unsigned char> meanPattern = validPatterns[0];
-                if (validPatterns.size() > 1) {
-                    for (size_t i = 1; i < validPatterns.size(); i++) {
-                        meanPattern += validPatterns[i];
-                    }
-                }
-                meanPattern /= validPatterns.size();
-
-                res(x, y, 0) = meanPattern(0, 0, 0);
-                res(x, y, 1) = meanPattern(0, 0, 1);
-                res(x, y, 2) = meanPattern(0, 0, 2);
-            }
-        }
-    }
-    res.resize(static_cast<int>(outWidth), static_cast<int>(outHeight), 1, 3, 1);
+    cimg::CImg<unsigned char> res = renderState();
 
     //directory + file name
     std::string filePath = dir + fileName;
@@ -425,6 +758,32 @@ void WFC::WFC::displayOutputImage(const std::string &dir, const std::string &fil
     res.save_png(filePath.c_str());
 }
 
+cimg::CImg<unsigned char> WFC::WFC::renderState() const {
+    //i had the height and weight switched for god knows how long and god damn it took me so long to fix this
+    cimg::CImg<unsigned char> res(outWidth, outHeight, 1, 3, 0);
+    const auto &palette = analyzer.getPalette();
+    for (int y = 0; y < outHeight; y++) {
+        for (int x = 0; x < outWidth; x++) {
+            //each cell shows the mean of the top left pixels of all its possible patterns
+            unsigned int sum[3] = {0, 0, 0};
+            size_t validPatterns = 0;
+            state.state.forEachPattern(state.state.cellIndex({x, y}), [&](size_t pattern) {
+                const uint8_t *color = palette.color(analyzer.getPatternIndex(pattern, 0, 0));
+                for (int c = 0; c < 3; c++) {
+                    sum[c] += color[std::min(c, palette.getSpectrum() - 1)];
+                }
+                validPatterns++;
+            });
+            if (validPatterns > 0) {
+                for (int c = 0; c < 3; c++) {
+                    res(x, y, 0, c) = static_cast<unsigned char>(sum[c] / validPatterns);
+                }
+            }
+        }
+    }
+    return res;
+}
+
 void WFC::WFC::logEntropyMatrix(const std::vector<std::vector<double>> &entropyMatrix) const {
     std::stringstream ss;
     for (const auto &i: entropyMatrix) {
@@ -439,44 +798,20 @@ void WFC::WFC::logEntropyMatrix(const std::vector<std::vector<double>> &entropyM
 
 void WFC::WFC::logState() {
     std::stringstream ss;
-    for (auto &i: state.state) {
-        ss << "[ ";
-        for (const auto &j: i) {
-            ss << " ";
-            ss << j.size();
+    for (size_t cell = 0; cell < state.state.getCellCount(); cell++) {
+        if (cell % outWidth == 0) {
+            ss << "[ ";
+        }
+        ss << " " << state.state.count(cell);
+        if ((cell + 1) % outWidth == 0) {
+            ss << " ] \n";
         }
-        ss << " ] ";
-        ss << "\n";
     }
     Util::Logger::log(Util::LogLevel::Debug, "State: \n" + ss.str());
 }
 
 void WFC::WFC::saveOutputImage() {
-    //i had the height and weight switched for god knows how long and god damn it took me so long to fix this
-    outputImage = cimg_library::CImg<unsigned char>(outWidth, outHeight, 1, 3, 0);
-    for (int y = 0; y < outHeight; y++) {
-        for (int x = 0; x < outWidth; x++) {
-            std::vector<cimg_library::CImg<unsigned char>> validPatterns;
-            for (int pattern = 0; pattern < analyzer.getPatterns().size(); pattern++) {
-                if (state.state.at(y).at(x).at(pattern)) {
-                    validPatterns.emplace_back(analyzer.getPatterns().at(pattern));
-                }
-            }
-            if (!validPatterns.empty()) {
-                cimg_library::CImg<unsigned char> meanPattern = validPatterns[0];
-                if (validPatterns.size() > 1) {
-                    for (size_t i = 1; i < validPatterns.size(); i++) {
-                        meanPattern += validPatterns[i];
-                    }
-                }
-                meanPattern /= validPatterns.size();
-
-                outputImage(x, y, 0) = meanPattern(0, 0, 0);
-                outputImage(x, y, 1) = meanPattern(0, 0, 1);
-                outputImage(x, y, 2) = meanPattern(0, 0, 2);
-            }
-        }
-    }
+    outputImage = renderState();
 }
 
 void WFC::WFC::saveOutput() const {
@@ -15,10 +15,15 @@
 #include <random>
 #include <iomanip>
 #include <sstream>
+#include <memory>
 
 #include "Analyzer.h"
 #include "Backtracker.h"
+#include "BatchSolver.h"
+#include "Wave.h"
 #include "../utility/FileUtil.h"
+#include "../utility/ThreadPool.h"
+#include "../utility/Random.h"
 
 namespace WFC {
 
@@ -37,6 +42,33 @@ namespace WFC {
         bool savePatterns;
     };
 
+    struct SolverOptions {
+        //number of threads used by the solver, with more than one the propagation runs in parallel rounds
+        size_t threads;
+        //cells collapsed per iteration, 1 collapses only the lowest entropy cell
+        size_t collapseBatch;
+        //cells collapsed in the same iteration have to be further apart than this
+        int collapseRadius;
+        //once half of the cells are collapsed, solve groups of cells that cannot affect each other separately
+        bool components;
+        //master seed, every random stream of the run is derived from it
+        uint64_t seed;
+    };
+
+    //streams split from the master seed, jobs and components get their own stream by index under these
+    enum class SeedStream : uint64_t {
+        Batch = 1,
+        Components = 2,
+    };
+
+    //cells of one component, used to backtrack inside that component only
+    struct ComponentSnapshot {
+        std::vector<uint64_t> words;
+        std::vector<int> collapsed;
+        //cells the attempt had collapsed when the snapshot was taken
+        size_t collapses;
+    };
+
     class WFC {
     public:
         WFC(const std::string_view &pathToInputImage, AnalyzerOptions &options, BacktrackerOptions &backtrackerOptions,
@@ -46,6 +78,9 @@ namespace WFC {
 
         bool startWFC();
 
+        //generates many outputs at once with the bit sliced batch solver, each one is saved to the output directory
+        bool startBatch(const BatchOptions &options);
+
         void setSavePaths(const WFCSavePaths &paths);
 
         void setAnalyzerOptions(const AnalyzerOptions &options);
@@ -56,6 +91,8 @@ namespace WFC {
 
         void setBacktrackerOptions(const BacktrackerOptions &options);
 
+        void setSolverOptions(const SolverOptions &options);
+
         void saveOutput() const;
 
     private:
@@ -63,7 +100,7 @@ namespace WFC {
 
         void fillEntropyMatrix(std::vector<std::vector<double>> &entropyMatrix);
 
-        Util::Point Observe();
+        std::vector<Util::Point> Observe();
 
         bool checkForContradiction() const;
 
@@ -72,11 +109,46 @@ namespace WFC {
         std::pair<Util::Point, std::vector<double>>
         findMinEntropyPoint(std::vector<std::vector<double>> &entropyMatrix);
 
+        std::vector<double> getPossibleProbabilities(const Util::Point &p) const;
+
+        std::vector<Util::Point>
+        findDistantPoints(const std::vector<std::vector<double>> &entropyMatrix, const Util::Point &first);
+
+        int wrappedDistance(const Util::Point &a, const Util::Point &b) const;
+
+        void rememberState();
+
+        bool rollbackBatch(const Util::Point &first);
+
         void collapseCell(const Util::Point &p, std::vector<double> &probabilities);
 
-        void propagate(Util::Point &minEntropyPoint);
+        //returns false if propagation ended in a contradiction
+        bool propagate(const std::vector<Util::Point> &collapsedPoints);
+
+        std::vector<std::vector<size_t>> findComponents();
+
+        void solveComponents(const std::vector<std::vector<size_t>> &components);
+
+        //false if every attempt ended in a contradiction, the cells of the component are restored then
+        bool solveComponent(int component, const std::vector<size_t> &cells, uint64_t componentSeed,
+                            std::vector<uint64_t> &mask, size_t &iterations);
+
+        //one attempt at the component, backtracks only within its own cells
+        bool searchComponent(int component, const std::vector<size_t> &cells, std::mt19937 &componentRng,
+                             std::vector<uint64_t> &mask, size_t &iterations);
+
+        bool propagateComponent(size_t startCell, int component, std::vector<uint64_t> &mask);
 
-        std::pair<bool, bool> updateCell(const Util::Point &current, const Util::Point &neighbour, const Util::Point &offset);
+        ComponentSnapshot saveComponent(const std::vector<size_t> &cells, size_t collapses) const;
+
+        void restoreComponent(const std::vector<size_t> &cells, const ComponentSnapshot &snapshot);
+
+        bool updateCell(size_t current, size_t neighbour, const Util::Point &offset, std::vector<uint64_t> &mask);
+
+        //sets mask to the patterns allowed at the offset by any of the patterns set in bits
+        void collectSupport(const uint64_t *bits, const Util::Point &offset, std::vector<uint64_t> &mask) const;
+
+        bool refreshCollapsed(size_t cell);
 
         Util::Point wrapPoint(const Util::Point &p, const Util::Point &offset) const;
 
@@ -90,14 +162,31 @@ namespace WFC {
 
         void saveOutputImage();
 
+        cimg::CImg<unsigned char> renderState() const;
+
     private:
         Analyzer analyzer;
         Backtracker backtracker;
         State state;
+        //state before the last collapse batch
+        State batchSnapshot;
         cimg::CImg<unsigned char> outputImage;
         std::mt19937 rng;
         WFCSavePaths savePaths;
         WFCStatus status;
+        SolverOptions solverOptions;
+        std::unique_ptr<Util::ThreadPool> threadPool;
+        //one support mask buffer per worker thread
+        std::vector<std::vector<uint64_t>> supportMasks;
+        //marks cells that are waiting in the propagation queue or in the next frontier
+        std::vector<std::atomic<bool>> queuedCells;
+        std::vector<size_t> nextFrontier;
+        //words of the frontier cells at the start of a propagation round
+        std::vector<uint64_t> frontierWords;
+        //component of every not collapsed cell, -1 for cells that are not part of any
+        std::vector<int> cellComponents;
+        //not collapsed cells at the last search for components
+        size_t lastComponentSearch = 0;
         size_t outWidth;
         size_t outHeight;
     };
@@ -0,0 +1,152 @@
+//
+// Created on 18.10.2026.
+//
+
+#include "Wave.h"
+
+WFC::Wave::Wave() : width(0), height(0), patternCount(0), wordsPerCell(0) {}
+
+WFC::Wave::Wave(size_t width, size_t height, size_t patternCount) :
+        width(width),
+        height(height),
+        patternCount(patternCount),
+        wordsPerCell((patternCount + 63) / 64),
+        words(width * height * wordsPerCell) {
+    //every pattern is possible at the start, bits past the pattern count stay zero
+    for (size_t cell = 0; cell < width * height; cell++) {
+        for (size_t word = 0; word < wordsPerCell; word++) {
+            size_t bitsInWord = std::min<size_t>(64, patternCount - word * 64);
+            uint64_t value = bitsInWord == 64 ? ~uint64_t{0} : (uint64_t{1} << bitsInWord) - 1;
+            words[cell * wordsPerCell + word].store(value, std::memory_order_relaxed);
+        }
+    }
+}
+
+WFC::Wave::Wave(const Wave &other) :
+        width(other.width),
+        height(other.height),
+        patternCount(other.patternCount),
+        wordsPerCell(other.wordsPerCell),
+        words(other.words.size()) {
+    for (size_t i = 0; i < words.size(); i++) {
+        words[i].store(other.words[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+}
+
+WFC::Wave &WFC::Wave::operator=(const Wave &other) {
+    if (this == &other) {
+        return *this;
+    }
+    width = other.width;
+    height = other.height;
+    patternCount = other.patternCount;
+    wordsPerCell = other.wordsPerCell;
+    if (words.size() != other.words.size()) {
+        words = std::vector<std::atomic<uint64_t>>(other.words.size());
+    }
+    for (size_t i = 0; i < words.size(); i++) {
+        words[i].store(other.words[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+    return *this;
+}
+
+bool WFC::Wave::empty() const {
+    return words.empty();
+}
+
+size_t WFC::Wave::getWidth() const {
+    return width;
+}
+
+size_t WFC::Wave::getHeight() const {
+    return height;
+}
+
+size_t WFC::Wave::getCellCount() const {
+    return width * height;
+}
+
+size_t WFC::Wave::getPatternCount() const {
+    return patternCount;
+}
+
+size_t WFC::Wave::getWordsPerCell() const {
+    return wordsPerCell;
+}
+
+size_t WFC::Wave::cellIndex(const Util::Point &p) const {
+    return static_cast<size_t>(p.y) * width + static_cast<size_t>(p.x);
+}
+
+Util::Point WFC::Wave::cellPoint(size_t cell) const {
+    return {static_cast<int>(cell % width), static_cast<int>(cell / width)};
+}
+
+bool WFC::Wave::get(size_t cell, size_t pattern) const {
+    return (getWord(cell, pattern / 64) >> (pattern % 64)) & 1;
+}
+
+uint64_t WFC::Wave::getWord(size_t cell, size_t word) const {
+    return words[cell * wordsPerCell + word].load(std::memory_order_relaxed);
+}
+
+size_t WFC::Wave::count(size_t cell) const {
+    size_t total = 0;
+    for (size_t word = 0; word < wordsPerCell; word++) {
+        total += static_cast<size_t>(__builtin_popcountll(getWord(cell, word)));
+    }
+    return total;
+}
+
+size_t WFC::Wave::firstPattern(size_t cell) const {
+    for (size_t word = 0; word < wordsPerCell; word++) {
+        uint64_t bits = getWord(cell, word);
+        if (bits) {
+            return word * 64 + static_cast<size_t>(__builtin_ctzll(bits));
+        }
+    }
+    return patternCount;
+}
+
+void WFC::Wave::setCell(size_t cell, const uint64_t *bits) {
+    for (size_t word = 0; word < wordsPerCell; word++) {
+        words[cell * wordsPerCell + word].store(bits[word], std::memory_order_relaxed);
+    }
+}
+
+void WFC::Wave::collapse(size_t cell, size_t pattern) {
+    for (size_t word = 0; word < wordsPerCell; word++) {
+        uint64_t value = (pattern / 64 == word) ? uint64_t{1} << (pattern % 64) : 0;
+        words[cell * wordsPerCell + word].store(value, std::memory_order_relaxed);
+    }
+}
+
+bool WFC::Wave::intersect(size_t cell, const uint64_t *mask) {
+    bool changed = false;
+    for (size_t word = 0; word < wordsPerCell; word++) {
+        auto &target = words[cell * wordsPerCell + word];
+        uint64_t old = target.load(std::memory_order_relaxed);
+        uint64_t updated = old & mask[word];
+        if (updated != old) {
+            target.store(updated, std::memory_order_relaxed);
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+bool WFC::Wave::intersectAtomic(size_t cell, const uint64_t *mask) {
+    bool changed = false;
+    for (size_t word = 0; word < wordsPerCell; word++) {
+        auto &target = words[cell * wordsPerCell + word];
+        //skip the read-modify-write when nothing would be removed, most updates do not change the cell
+        if ((target.load(std::memory_order_relaxed) & ~mask[word]) == 0) {
+            continue;
+        }
+        uint64_t old = target.fetch_and(mask[word], std::memory_order_relaxed);
+        if (old & ~mask[word]) {
+            changed = true;
+        }
+    }
+    return changed;
+}
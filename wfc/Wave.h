@@ -0,0 +1,89 @@
+//
+// Created on 18.10.2026.
+//
+
+#ifndef WFC_WAVE_H
+#define WFC_WAVE_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "../utility/Point.h"
+
+namespace WFC {
+
+    //superposition of the whole output, every cell stores one bit per pattern packed into 64 bit words
+    class Wave {
+    public:
+        Wave();
+
+        Wave(size_t width, size_t height, size_t patternCount);
+
+        Wave(const Wave &other);
+
+        Wave &operator=(const Wave &other);
+
+        [[nodiscard]] bool empty() const;
+
+        [[nodiscard]] size_t getWidth() const;
+
+        [[nodiscard]] size_t getHeight() const;
+
+        [[nodiscard]] size_t getCellCount() const;
+
+        [[nodiscard]] size_t getPatternCount() const;
+
+        [[nodiscard]] size_t getWordsPerCell() const;
+
+        [[nodiscard]] size_t cellIndex(const Util::Point &p) const;
+
+        [[nodiscard]] Util::Point cellPoint(size_t cell) const;
+
+        [[nodiscard]] bool get(size_t cell, size_t pattern) const;
+
+        [[nodiscard]] uint64_t getWord(size_t cell, size_t word) const;
+
+        //number of patterns still possible in the cell
+        [[nodiscard]] size_t count(size_t cell) const;
+
+        //index of the first possible pattern, pattern count if there is none
+        [[nodiscard]] size_t firstPattern(size_t cell) const;
+
+        //overwrites all words of the cell with bits
+        void setCell(size_t cell, const uint64_t *bits);
+
+        //removes every pattern from the cell except the given one
+        void collapse(size_t cell, size_t pattern);
+
+        //keeps only patterns that are also in mask, returns true if any pattern was removed
+        bool intersect(size_t cell, const uint64_t *mask);
+
+        //same as intersect, but uses atomic fetch-and so that multiple threads can update the same cell
+        bool intersectAtomic(size_t cell, const uint64_t *mask);
+
+        //calls f with index of every possible pattern in the cell
+        template<typename F>
+        void forEachPattern(size_t cell, F f) const {
+            for (size_t word = 0; word < wordsPerCell; word++) {
+                uint64_t bits = getWord(cell, word);
+                while (bits) {
+                    f(word * 64 + static_cast<size_t>(__builtin_ctzll(bits)));
+                    bits &= bits - 1;
+                }
+            }
+        }
+
+    private:
+        size_t width;
+        size_t height;
+        size_t patternCount;
+        size_t wordsPerCell;
+        //atomic so that parallel propagation can update cells in place, sequential code uses relaxed access
+        std::vector<std::atomic<uint64_t>> words;
+    };
+}
+
+#endif //WFC_WAVE_H